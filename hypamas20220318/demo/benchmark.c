@@ -5,7 +5,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "hypamas_api.h"
+#include <time.h>
+#include "hypamas_ext.h"
+
+static double WallTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
 
 int main(int argc, char *argv[])
 {
@@ -13,10 +21,11 @@ int main(int argc, char *argv[])
     void *handler;
     int *iparm;
     double *dparm;
-    int n, nnz, i;
+    int n, nnz, i, len, mode;
     double *ax;
     int *ap, *ai;
-    double *rhs, *sol, rerr, memuse;
+    double *rhs, *sol, *asol, *next, rerr, memuse, t0, t1;
+    void *ilu, *map, *values, *request;
 
     if (argc < 3)
         return 0;
@@ -25,6 +34,10 @@ int main(int argc, char *argv[])
     ai = NULL;
     ap = NULL;
     sol = NULL;
+    asol = NULL;
+    ilu = NULL;
+    values = NULL;
+    map = NULL;
 
     // initialize Hypamas, call it only once
     retval = HypamasInit(&handler, &iparm, &dparm);
@@ -38,12 +51,36 @@ int main(int argc, char *argv[])
     // iparm[kIparmAutoParallelOff] = 1; // turn off automatic thread control
     iparm[kIparmSolveTranspose] = 0; // solve A*x=b
 
-    // read matrix from matrix market file
-    retval = Hypamas_ReadMatrixMarketFile(argv[1], &n, &nnz, &ax, &ap, &ai, 0);
-    if (FAIL(retval))
+    // map a binary matrix file(*.csr) without copy, or read matrix from matrix market file in parallel
+    len = strlen(argv[1]);
+    if (len > 4 && 0 == strcmp(argv[1] + len - 4, ".csr"))
     {
-        printf("read matrix market file error = %d\n", retval);
-        goto FINAL;
+        retval = Hypamas_MapBinaryMatrixFile(argv[1], &n, &nnz, &ax, &ap, &ai, &mode, &map);
+        if (FAIL(retval) || 0 != mode)
+        {
+            printf("map binary matrix file error = %d\n", retval);
+            goto FINAL;
+        }
+    }
+    else
+    {
+        retval = Hypamas_ReadMatrixMarketFileParallel(argv[1], &n, &nnz, &ax, &ap, &ai, 0, atoi(argv[2]));
+        if (FAIL(retval))
+        {
+            printf("read matrix market file error = %d\n", retval);
+            goto FINAL;
+        }
+    }
+
+    // optionally save the matrix in binary format for the next run
+    if (argc > 3)
+    {
+        retval = Hypamas_WriteBinaryMatrixFile(argv[3], n, nnz, ax, ap, ai, 0);
+        if (FAIL(retval))
+        {
+            printf("write binary matrix file error = %d\n", retval);
+            goto FINAL;
+        }
     }
 
     sol = (double *)malloc(sizeof(double) * n * 2);
@@ -173,6 +210,39 @@ int main(int argc, char *argv[])
     printf("number of iterative refinement = %d\n", iparm[kIparmIterNum]);
     printf("after refinement |b-A*x|_F: %.8g\n", rerr);
 
+    printf("\n");
+
+    // solution of the asynchronous request
+    asol = (double *)malloc(sizeof(double) * n);
+
+    // refactorize, solve and check the residual in the background, the next values may be stamped meanwhile
+    retval = HypamasValueBufferCreate(&values, nnz);
+    if (FAIL(retval))
+    {
+        printf("value buffer error = %d\n", retval);
+        goto FINAL;
+    }
+    HypamasValueBufferNext(values, &next);
+    memcpy(next, ax, sizeof(double) * nnz);
+    t0 = WallTime();
+    retval = HypamasReFactorizeSolveAsync(handler, NULL, values, ap, ai, rhs, asol, &rerr, 0, &request);
+    if (FAIL(retval))
+    {
+        printf("asynchronous submission error = %d\n", retval);
+        goto FINAL;
+    }
+    t1 = WallTime();
+    HypamasValueBufferNext(values, &next);
+    memcpy(next, ax, sizeof(double) * nnz);
+    retval = HypamasWait(&request);
+    if (FAIL(retval))
+    {
+        printf("asynchronous refactorization error = %d\n", retval);
+        goto FINAL;
+    }
+    printf("asynchronous refact & solve time: %.8g, submission time: %.8g\n", WallTime() - t0, t1 - t0);
+    printf("|b-A*x|_F: %.8g\n", rerr);
+
     printf("\n==========\n");
 
     iparm[kIparmStagnationStep] = 25;
@@ -204,14 +274,83 @@ int main(int argc, char *argv[])
     HypamasResidualNorm(handler, ax, ap, ai, sol, rhs, NULL, &rerr, NULL);
     printf("|b-A*x|_F: %.8g\n", rerr);
 
+    printf("\n");
+
+    // GMRES with the Arnoldi process running on the created threads, one reduction per iteration
+    iparm[kIparmGMRESOrthogonalization] = kCfgGMRESOrthSingleReduce;
+    memset(sol, 0, sizeof(double) * n);
+    retval = HypamasParallelGMRES(handler, ax, ap, ai, rhs, sol, 0);
+    if (FAIL(retval))
+    {
+        printf("parallel GMRES error = %d\n", retval);
+        goto FINAL;
+    }
+    printf("parallel gmres iterating time: %.8g\n", dparm[kDparmSolveTime]);
+    printf("number of iterative refinement = %d, threads = %d\n", iparm[kIparmIterNum], iparm[kIparmThreadUsed]);
+
+    HypamasResidualNorm(handler, ax, ap, ai, sol, rhs, NULL, &rerr, NULL);
+    printf("|b-A*x|_F: %.8g\n", rerr);
+
+    // GMRES preconditioned by ILU(2) with level-scheduled triangular solves
+    retval = HypamasLevelILUInit(&ilu, 2);
+    if (FAIL(retval))
+    {
+        printf("level ILU initilization error = %d\n", retval);
+        goto FINAL;
+    }
+    retval = HypamasLevelILUFactorize(ilu, n, ax, ap, ai, iparm[kIparmSolveTranspose], iparm[kIparmThreadCreated]);
+    if (FAIL(retval))
+    {
+        printf("level ILU factorization error = %d\n", retval);
+        goto FINAL;
+    }
+
+    // refactorize ILU(2) with the rows split level by level, then with work stealing
+    t0 = WallTime();
+    retval = HypamasLevelILUFactorize(ilu, n, ax, ap, ai, iparm[kIparmSolveTranspose], iparm[kIparmThreadCreated]);
+    t0 = WallTime() - t0;
+    HypamasLevelILUSetSchedule(ilu, kCfgILUScheduleSteal);
+    t1 = WallTime();
+    if (!FAIL(retval))
+        retval = HypamasLevelILUFactorize(ilu, n, ax, ap, ai, iparm[kIparmSolveTranspose], iparm[kIparmThreadCreated]);
+    t1 = WallTime() - t1;
+    if (FAIL(retval))
+    {
+        printf("level ILU refactorization error = %d\n", retval);
+        goto FINAL;
+    }
+    printf("level ILU refactorization time(level sets): %.8g\n", t0);
+    printf("level ILU refactorization time(work stealing): %.8g\n", t1);
+
+    memset(sol, 0, sizeof(double) * n);
+    retval = HypamasLevelILUGMRES(handler, ilu, ax, ap, ai, rhs, sol, 0);
+    if (FAIL(retval))
+    {
+        printf("level ILU GMRES error = %d\n", retval);
+        goto FINAL;
+    }
+    printf("level ILU gmres iterating time: %.8g\n", dparm[kDparmSolveTime]);
+    printf("number of iterative refinement = %d, threads = %d\n", iparm[kIparmIterNum], iparm[kIparmThreadUsed]);
+
+    HypamasResidualNorm(handler, ax, ap, ai, sol, rhs, NULL, &rerr, NULL);
+    printf("|b-A*x|_F: %.8g\n", rerr);
+
     HypamasEstimateMemoryUsage(handler, &memuse);
     printf("memory usage(MB): %g\n", memuse);
 
 FINAL:
 
     HypamasFinalize(handler);
+    if (NULL != ilu)
+        HypamasLevelILUFinalize(ilu);
+    if (NULL != map)
+        Hypamas_UnmapBinaryMatrixFile(map);
     if (NULL != sol)
         free(sol);
+    if (NULL != asol)
+        free(asol);
+    if (NULL != values)
+        HypamasValueBufferFree(values);
 
     return 0;
 }
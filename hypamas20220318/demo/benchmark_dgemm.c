@@ -0,0 +1,226 @@
+/*demo: used to measure the dense dgemm & dtrsm kernels against the flops of LU factorization*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "hypamas_ext.h"
+
+static double WallTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static void FillRandom(double *x, int len)
+{
+    int i;
+    for (i = 0; i < len; ++i)
+        x[i] = (double)rand() / RAND_MAX - 0.5;
+}
+
+// error of C = A*B + C against a naive triple loop
+static double CheckDgemm(int m, int n, int k)
+{
+    double *a, *b, *c, *r, err;
+    int i, j, p;
+
+    a = (double *)malloc(sizeof(double) * (m * k + k * n + 2 * m * n));
+    b = a + m * k;
+    c = b + k * n;
+    r = c + m * n;
+    FillRandom(a, m * k + k * n + m * n);
+    memcpy(r, c, sizeof(double) * m * n);
+
+    Hypamas_dgemm(m, n, k, 1., a, m, b, k, 1., c, m);
+    for (j = 0; j < n; ++j)
+        for (p = 0; p < k; ++p)
+            for (i = 0; i < m; ++i)
+                r[j * m + i] += a[p * m + i] * b[j * k + p];
+
+    err = 0.;
+    for (i = 0; i < m * n; ++i)
+        err = fmax(err, fabs(r[i] - c[i]));
+    free(a);
+    return err;
+}
+
+// GFlops of C = C - A*B with a supernode-shaped A(m x k)
+static double TimeDgemm(int m, int n, int k, int repeat)
+{
+    double *a, *b, *c, t;
+    int r;
+
+    a = (double *)malloc(sizeof(double) * (m * k + k * n + m * n));
+    b = a + m * k;
+    c = b + k * n;
+    FillRandom(a, m * k + k * n + m * n);
+
+    Hypamas_dgemm(m, n, k, -1., a, m, b, k, 1., c, m);
+    t = WallTime();
+    for (r = 0; r < repeat; ++r)
+        Hypamas_dgemm(m, n, k, -1., a, m, b, k, 1., c, m);
+    t = WallTime() - t;
+
+    free(a);
+    return 2. * m * n * k * repeat / t * 1e-9;
+}
+
+// residual |A*X - B| of X = inv(A)*B over lower & upper, unit & non-unit triangular A(m x m)
+static double CheckDtrsm(int m, int n)
+{
+    double *a, *b, *x, s, err;
+    int uplo, diag, i, j, p, lo, hi;
+
+    a = (double *)malloc(sizeof(double) * (m * m + 2 * m * n));
+    b = a + m * m;
+    x = b + m * n;
+    err = 0.;
+    for (uplo = kUploLower; uplo <= kUploUpper; ++uplo)
+    {
+        for (diag = kDiagNonUnit; diag <= kDiagUnit; ++diag)
+        {
+            // a dominant diagonal keeps the solution bounded, the unit case ignores the stored diagonal
+            FillRandom(a, m * m + m * n);
+            for (i = 0; i < m; ++i)
+                a[i * m + i] = kDiagUnit == diag ? 1e3 : (double)m;
+            memcpy(x, b, sizeof(double) * m * n);
+            Hypamas_dtrsm(uplo, diag, m, n, a, m, x, m);
+
+            for (j = 0; j < n; ++j)
+            {
+                for (i = 0; i < m; ++i)
+                {
+                    lo = kUploLower == uplo ? 0 : i + 1;
+                    hi = kUploLower == uplo ? i : m;
+                    s = kDiagUnit == diag ? x[j * m + i] : a[i * m + i] * x[j * m + i];
+                    for (p = lo; p < hi; ++p)
+                        s += a[p * m + i] * x[j * m + p];
+                    err = fmax(err, fabs(s - b[j * m + i]));
+                }
+            }
+        }
+    }
+    free(a);
+    return err;
+}
+
+// GFlops of B = inv(L)*B with a unit lower triangular L(m x m)
+static double TimeDtrsm(int m, int n, int repeat)
+{
+    double *a, *b, t;
+    int r, i;
+
+    a = (double *)malloc(sizeof(double) * (m * m + m * n));
+    b = a + m * m;
+    FillRandom(a, m * m + m * n);
+    for (i = 0; i < m; ++i)
+        a[i * m + i] = 1.;
+
+    t = WallTime();
+    for (r = 0; r < repeat; ++r)
+        Hypamas_dtrsm(kUploLower, kDiagUnit, m, n, a, m, b, m);
+    t = WallTime() - t;
+
+    free(a);
+    return (double)m * m * n * repeat / t * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+    int retval;
+    void *handler;
+    int *iparm;
+    double *dparm;
+    int n, nnz, kernel, row, i;
+    double *ax;
+    int *ap, *ai;
+    double gflops, factrate, rate;
+    static const int widths[] = {56, 256, 1024};
+
+    ax = NULL;
+    ap = NULL;
+    ai = NULL;
+    gflops = 0.;
+    factrate = 0.;
+    row = 56;
+
+    retval = HypamasInit(&handler, &iparm, &dparm);
+    if (FAIL(retval))
+    {
+        printf("initilization error = %d\n", retval);
+        return 0;
+    }
+    iparm[kIparmTimer] = 1;
+
+    // flops of the LU factorization as the reference
+    if (argc > 1)
+    {
+        retval = Hypamas_ReadMatrixMarketFile(argv[1], &n, &nnz, &ax, &ap, &ai, 0);
+        if (FAIL(retval))
+        {
+            printf("read matrix market file error = %d\n", retval);
+            goto FINAL;
+        }
+        retval = HypamasAnalyze(handler, n, ax, ap, ai);
+        if (FAIL(retval))
+        {
+            printf("analysis error = %d\n", retval);
+            goto FINAL;
+        }
+        retval = HypamasFactorize(handler, ax, 0);
+        if (FAIL(retval))
+        {
+            printf("factorization error = %d\n", retval);
+            goto FINAL;
+        }
+        gflops = dparm[kDparmGFlopsAnalyzed];
+        factrate = gflops / dparm[kDparmFactTime];
+        row = iparm[kIparmSupernodeMaxRow];
+        printf("N = %d, NNZ = %d\n", n, nnz);
+        printf("estimated FLOPS(GFlops): %g\n", gflops);
+        printf("sequential fact time: %.8g, GFlops/s: %.4g\n", dparm[kDparmFactTime], factrate);
+    }
+
+    printf("\n==========\n");
+    printf("%-12s %6s %6s %6s %10s %10s\n", "kernel", "m", "n", "k", "GFlops/s", "error");
+    for (kernel = kDgemmKernelGeneric; kernel <= kDgemmKernelAVX512; ++kernel)
+    {
+        if (FAIL(Hypamas_SelectDgemmKernel(kernel)))
+            continue;
+        for (i = 0; i < (int)(sizeof(widths) / sizeof(widths[0])); ++i)
+        {
+            rate = TimeDgemm(row, widths[i], row, 20000000 / (row * widths[i] * row) + 1);
+            printf("%-12s %6d %6d %6d %10.4g %10.3g\n", Hypamas_DgemmKernelName(), row, widths[i], row, rate,
+                   CheckDgemm(row + 3, widths[i] + 5, row + 1));
+        }
+        rate = TimeDgemm(1024, 1024, 256, 2);
+        printf("%-12s %6d %6d %6d %10.4g %10.3g\n", Hypamas_DgemmKernelName(), 1024, 1024, 256, rate, CheckDgemm(131, 77, 300));
+        if (gflops > 0.)
+            printf("%-12s analyzed flops would take %.8g at %.4g GFlops/s (%.3gx of factorization)\n",
+                   Hypamas_DgemmKernelName(), gflops / rate, rate, rate / factrate);
+    }
+
+    Hypamas_SelectDgemmKernel(kDgemmKernelAuto);
+    printf("\n==========\n");
+    printf("%-12s %6s %6s %10s %10s\n", "dtrsm", "m", "n", "GFlops/s", "error");
+    for (i = 0; i < (int)(sizeof(widths) / sizeof(widths[0])); ++i)
+        printf("%-12s %6d %6d %10.4g %10.3g\n", Hypamas_DgemmKernelName(), row, widths[i], TimeDtrsm(row, widths[i], 20000000 / (row * widths[i] * row) + 1),
+               CheckDtrsm(row + 3, widths[i] + 5));
+
+FINAL:
+
+    HypamasFinalize(handler);
+    if (NULL != ax)
+        free(ax);
+    if (NULL != ap)
+        free(ap);
+    if (NULL != ai)
+        free(ai);
+
+    return 0;
+}
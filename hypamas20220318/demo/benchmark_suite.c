@@ -0,0 +1,866 @@
+/*demo: used to run a reproducible benchmark suite over matrices, thread counts and kernel paths*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "hypamas_ext.h"
+
+#define MAX_MATRICES 256
+#define MAX_THREADS 16
+
+static double WallTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+typedef struct
+{
+    char name[256];
+    int n, nnz;
+    double *ax;
+    int *ap, *ai;
+    void *map; // mapping of a binary file, NULL if the arrays are allocated
+} Matrix;
+
+// a refactorization path selected through iparm, the library picks its kernel from them
+typedef struct
+{
+    const char *name;
+    int param; // iparm to override, -1 for none
+    int value; // -1 for n + 1
+} Kernel;
+
+static const Kernel g_kernels[] = {
+    {"default", -1, 0},
+    {"column", kIparmSupernodeMinColumn, -1}, // no supernode reaches n + 1 columns
+    {"panel32", kIparmPanelSize, 32},
+    {"maplink", kIparmMapLinkOff, 0},
+};
+#define KERNELS ((int)(sizeof(g_kernels) / sizeof(g_kernels[0])))
+
+typedef struct
+{
+    int warmup;
+    int repeat;
+    int json;
+    int timeout; // seconds of one case, 0 for none
+    char *cache; // tuning cache of HypamasTune, NULL for none
+    int records;
+    FILE *out;
+} Suite;
+
+static int CompareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// median & 95th percentile(nearest rank) of t[0..k-1], t is sorted in place
+static void Percentiles(double *t, int k, double *median, double *p95)
+{
+    int r;
+
+    qsort(t, k, sizeof(double), CompareDouble);
+    *median = k % 2 ? t[k / 2] : 0.5 * (t[k / 2 - 1] + t[k / 2]);
+    r = (95 * k + 99) / 100;
+    *p95 = t[(r < 1 ? 1 : r) - 1];
+}
+
+static void Record(Suite *s, const Matrix *m, int threads, const char *kernel, const char *phase,
+                   double *t, int k, double gflop, double memuse, double residual, int iterations, int status)
+{
+    double median, p95;
+
+    median = p95 = 0.;
+    if (k > 0)
+        Percentiles(t, k, &median, &p95);
+
+    if (s->json)
+    {
+        fprintf(s->out, "%s\n  {\"matrix\": \"%s\", \"n\": %d, \"nnz\": %d, \"threads\": %d, \"kernel\": \"%s\", \"phase\": \"%s\", "
+                        "\"runs\": %d, \"median\": %.6e, \"p95\": %.6e, \"gflops\": %.6g, \"memory_mb\": %.6g, \"residual\": %.6e, \"iterations\": %d, \"status\": %d}",
+                s->records ? "," : "", m->name, m->n, m->nnz, threads, kernel, phase,
+                k, median, p95, median > 0. ? gflop / median : 0., memuse, residual, iterations, status);
+    }
+    else
+    {
+        if (0 == s->records)
+            fprintf(s->out, "matrix,n,nnz,threads,kernel,phase,runs,median,p95,gflops,memory_mb,residual,iterations,status\n");
+        fprintf(s->out, "%s,%d,%d,%d,%s,%s,%d,%.6e,%.6e,%.6g,%.6g,%.6e,%d,%d\n",
+                m->name, m->n, m->nnz, threads, kernel, phase,
+                k, median, p95, median > 0. ? gflop / median : 0., memuse, residual, iterations, status);
+    }
+    ++s->records;
+    fflush(s->out);
+}
+
+// circuit-like matrix: resistor chains and meshes between neighbouring nodes, a few supply rails touching many nodes,
+// controlled sources adding unsymmetric entries, and voltage source branches with a zero diagonal
+static void GenerateCircuit(int n, unsigned int seed, Matrix *m)
+{
+    int *cnt, *next, nrails, nsrc, i, j, k, e, p, q, cap, *ei, *ej;
+    double *ev, g;
+
+    nrails = n >= 1000 ? 4 : 1;
+    nsrc = n / 200;
+    cap = 8 * n + 64;
+    ei = (int *)malloc(sizeof(int) * cap);
+    ej = (int *)malloc(sizeof(int) * cap);
+    ev = (double *)malloc(sizeof(double) * cap);
+    e = 0;
+
+#define RAND() (seed = seed * 1103515245u + 12345u, (seed >> 8) & 0xffffff)
+#define STAMP(a, b, v) (ei[e] = (a), ej[e] = (b), ev[e] = (v), ++e)
+    for (i = 0; i < n - nsrc; ++i)
+    {
+        // conductance to a near node and to one a row of the mesh away
+        for (k = 0; k < 2; ++k)
+        {
+            j = 0 == k ? i + 1 + (int)(RAND() % 3) : i + 64 + (int)(RAND() % 8);
+            if (j >= n - nsrc)
+                continue;
+            g = 1e-3 + 1e-3 * (double)(RAND() % 1000);
+            STAMP(i, i, g);
+            STAMP(j, j, g);
+            STAMP(i, j, -g);
+            STAMP(j, i, -g);
+        }
+        STAMP(i, i, 1e-9); // leakage to ground
+        if (0 == RAND() % 50)
+        {
+            // transconductance, unsymmetric
+            j = (int)(RAND() % (unsigned int)(n - nsrc));
+            if (j != i)
+                STAMP(i, j, 1e-2);
+        }
+        if (e + 16 > cap)
+        {
+            cap *= 2;
+            ei = (int *)realloc(ei, sizeof(int) * cap);
+            ej = (int *)realloc(ej, sizeof(int) * cap);
+            ev = (double *)realloc(ev, sizeof(double) * cap);
+        }
+    }
+    for (k = 0; k < nrails; ++k)
+    {
+        // supply rail tied to every 16th node, a dense row & column
+        j = (int)(RAND() % (unsigned int)(n - nsrc));
+        for (i = k; i < n - nsrc; i += 16)
+        {
+            if (i == j)
+                continue;
+            if (e + 4 > cap)
+            {
+                cap *= 2;
+                ei = (int *)realloc(ei, sizeof(int) * cap);
+                ej = (int *)realloc(ej, sizeof(int) * cap);
+                ev = (double *)realloc(ev, sizeof(double) * cap);
+            }
+            STAMP(i, i, 1e-4);
+            STAMP(j, j, 1e-4);
+            STAMP(i, j, -1e-4);
+            STAMP(j, i, -1e-4);
+        }
+    }
+    for (k = 0; k < nsrc; ++k)
+    {
+        // voltage source between a node and ground, branch current as unknown
+        if (e + 2 > cap)
+        {
+            cap *= 2;
+            ei = (int *)realloc(ei, sizeof(int) * cap);
+            ej = (int *)realloc(ej, sizeof(int) * cap);
+            ev = (double *)realloc(ev, sizeof(double) * cap);
+        }
+        i = n - nsrc + k;
+        j = (int)(RAND() % (unsigned int)(n - nsrc));
+        STAMP(i, j, 1.);
+        STAMP(j, i, 1.);
+    }
+#undef STAMP
+#undef RAND
+
+    // CSR with duplicates summed
+    m->n = n;
+    m->ap = (int *)calloc(n + 1, sizeof(int));
+    cnt = (int *)calloc(n + 1, sizeof(int));
+    for (p = 0; p < e; ++p)
+        ++cnt[ei[p] + 1];
+    for (i = 0; i < n; ++i)
+        cnt[i + 1] += cnt[i];
+    next = (int *)malloc(sizeof(int) * n);
+    memcpy(next, cnt, sizeof(int) * n);
+    m->ai = (int *)malloc(sizeof(int) * e);
+    m->ax = (double *)malloc(sizeof(double) * e);
+    for (p = 0; p < e; ++p)
+    {
+        q = next[ei[p]]++;
+        m->ai[q] = ej[p];
+        m->ax[q] = ev[p];
+    }
+    q = 0;
+    for (i = 0; i < n; ++i)
+    {
+        // insertion sort of the row, then merge equal columns
+        for (p = cnt[i] + 1; p < cnt[i + 1]; ++p)
+        {
+            j = m->ai[p];
+            g = m->ax[p];
+            for (k = p - 1; k >= cnt[i] && m->ai[k] > j; --k)
+            {
+                m->ai[k + 1] = m->ai[k];
+                m->ax[k + 1] = m->ax[k];
+            }
+            m->ai[k + 1] = j;
+            m->ax[k + 1] = g;
+        }
+        m->ap[i] = q;
+        for (p = cnt[i]; p < cnt[i + 1]; ++p)
+        {
+            if (q > m->ap[i] && m->ai[q - 1] == m->ai[p])
+            {
+                m->ax[q - 1] += m->ax[p];
+            }
+            else
+            {
+                m->ai[q] = m->ai[p];
+                m->ax[q] = m->ax[p];
+                ++q;
+            }
+        }
+    }
+    m->ap[n] = q;
+    m->nnz = q;
+    m->map = NULL;
+    snprintf(m->name, sizeof(m->name), "circuit%d", n);
+
+    free(cnt);
+    free(next);
+    free(ei);
+    free(ej);
+    free(ev);
+}
+
+static int LoadMatrix(const char *file, Matrix *m)
+{
+    const char *base;
+    size_t len;
+    int mode, retval;
+
+    base = strrchr(file, '/');
+    snprintf(m->name, sizeof(m->name), "%s", NULL != base ? base + 1 : file);
+    m->map = NULL;
+    len = strlen(file);
+    if (len > 4 && 0 == strcmp(file + len - 4, ".csr"))
+    {
+        retval = Hypamas_MapBinaryMatrixFile((char *)file, &m->n, &m->nnz, &m->ax, &m->ap, &m->ai, &mode, &m->map);
+        if (OK(retval) && 0 != mode)
+        {
+            Hypamas_UnmapBinaryMatrixFile(m->map);
+            retval = kErrorInvalidArgument;
+        }
+        return retval;
+    }
+    return Hypamas_ReadMatrixMarketFileParallel((char *)file, &m->n, &m->nnz, &m->ax, &m->ap, &m->ai, 0, 1);
+}
+
+static void FreeMatrix(Matrix *m)
+{
+    if (NULL != m->map)
+    {
+        Hypamas_UnmapBinaryMatrixFile(m->map);
+        return;
+    }
+    free(m->ax);
+    free(m->ap);
+    free(m->ai);
+}
+
+// a handler analyzed for m with threads, the iparm of kernel applied
+static int Prepare(const Matrix *m, int threads, const Kernel *kernel, void **handler, int **iparm, double **dparm, double *analyze)
+{
+    int retval;
+    double t;
+
+    retval = HypamasInit(handler, iparm, dparm);
+    if (FAIL(retval))
+        return retval;
+    (*iparm)[kIparmAutoParallelOff] = 1; // the sweep sets the threads
+    if (NULL != kernel && kernel->param >= 0)
+        (*iparm)[kernel->param] = kernel->value < 0 ? m->n + 1 : kernel->value;
+
+    t = WallTime();
+    retval = HypamasAnalyze(*handler, m->n, m->ax, m->ap, m->ai);
+    *analyze = WallTime() - t;
+    if (FAIL(retval))
+        return retval;
+    return HypamasInitThreads(*handler, threads);
+}
+
+static void RunDirect(Suite *s, const Matrix *m, int threads, const Kernel *kernel, double *t, double *rhs, double *sol)
+{
+    void *handler;
+    int *iparm, retval, r, k, runs, solve_threads;
+    double *dparm, analyze, gflop, memuse, rerr;
+
+    runs = s->warmup + s->repeat;
+    retval = Prepare(m, threads, kernel, &handler, &iparm, &dparm, &analyze);
+    if (FAIL(retval))
+    {
+        Record(s, m, threads, kernel->name, "analyze", t, 0, 0., 0., 0., 0, retval);
+        HypamasFinalize(handler);
+        return;
+    }
+    gflop = dparm[kDparmGFlopsAnalyzed];
+    t[0] = analyze;
+    Record(s, m, threads, kernel->name, "analyze", t, 1, 0., 0., 0., 0, retval);
+
+    // the first factorization pivots, the next ones reuse its pattern
+    for (r = k = 0; r < runs; ++r)
+    {
+        t[k] = WallTime();
+        retval = HypamasFactorize(handler, m->ax, threads);
+        t[k] = WallTime() - t[k];
+        if (FAIL(retval))
+            break;
+        if (r >= s->warmup)
+            ++k;
+    }
+    HypamasEstimateMemoryUsage(handler, &memuse);
+    Record(s, m, threads, kernel->name, "factorize", t, k, gflop, memuse, 0., 0, retval);
+    if (FAIL(retval))
+        goto FINAL;
+
+    for (r = k = 0; r < runs; ++r)
+    {
+        t[k] = WallTime();
+        retval = HypamasReFactorize(handler, m->ax, threads);
+        t[k] = WallTime() - t[k];
+        if (FAIL(retval))
+            break;
+        if (r >= s->warmup)
+            ++k;
+    }
+    Record(s, m, threads, kernel->name, "refactorize", t, k, gflop, memuse, 0., 0, retval);
+    if (FAIL(retval))
+        goto FINAL;
+
+    // sequential and parallel triangular solves
+    for (solve_threads = 1; solve_threads <= threads; solve_threads = threads > 1 && solve_threads == 1 ? threads : threads + 1)
+    {
+        for (r = k = 0; r < runs; ++r)
+        {
+            t[k] = WallTime();
+            retval = HypamasSolve(handler, rhs, sol, solve_threads);
+            t[k] = WallTime() - t[k];
+            if (FAIL(retval))
+                break;
+            if (r >= s->warmup)
+                ++k;
+        }
+        rerr = 0.;
+        HypamasResidualNorm(handler, m->ax, m->ap, m->ai, sol, rhs, NULL, &rerr, NULL);
+        Record(s, m, threads, kernel->name, 1 == solve_threads ? "solve_seq" : "solve_par", t, k, 0., memuse, rerr, 0, retval);
+    }
+
+FINAL:
+
+    HypamasFinalize(handler);
+}
+
+static void RunIterative(Suite *s, const Matrix *m, int threads, int algorithm, double *t, double *rhs, double *sol)
+{
+    static const char *names[] = {"gmres_off", "gmres_silutp", "gmres_silut", "gmres_pilutp", "gmres_pilut", "gmres_snilutp"};
+    void *handler;
+    int *iparm, retval, r, k, i, runs, iterations;
+    double *dparm, analyze, memuse, rerr;
+
+    runs = s->warmup + s->repeat;
+    retval = Prepare(m, threads, NULL, &handler, &iparm, &dparm, &analyze);
+    if (FAIL(retval))
+    {
+        Record(s, m, threads, names[algorithm], "gmres", t, 0, 0., 0., 0., 0, retval);
+        HypamasFinalize(handler);
+        return;
+    }
+    iparm[kIparmInFactAlgorithm] = algorithm;
+    iparm[kIparmStagnationStep] = 25;
+
+    for (r = k = 0; r < runs; ++r)
+    {
+        t[k] = WallTime();
+        retval = HypamasInFactorize(handler, m->ax, threads);
+        t[k] = WallTime() - t[k];
+        if (FAIL(retval))
+            break;
+        if (r >= s->warmup)
+            ++k;
+    }
+    HypamasEstimateMemoryUsage(handler, &memuse);
+    Record(s, m, threads, names[algorithm], "infactorize", t, k, 0., memuse, 0., 0, retval);
+    if (FAIL(retval))
+        goto FINAL;
+
+    iterations = 0;
+    for (r = k = 0; r < runs; ++r)
+    {
+        for (i = 0; i < m->n; ++i)
+            sol[i] = 0.;
+        t[k] = WallTime();
+        retval = HypamasGMRES(handler, m->ax, m->ap, m->ai, rhs, sol);
+        t[k] = WallTime() - t[k];
+        iterations = iparm[kIparmIterNum];
+        if (FAIL(retval))
+            break;
+        if (r >= s->warmup)
+            ++k;
+    }
+    rerr = 0.;
+    HypamasResidualNorm(handler, m->ax, m->ap, m->ai, sol, rhs, NULL, &rerr, NULL);
+    Record(s, m, threads, names[algorithm], "gmres", t, k, 0., memuse, rerr, iterations, retval);
+
+FINAL:
+
+    HypamasFinalize(handler);
+}
+
+// the ILU(k) of the extension with the parallel GMRES
+static void RunLevelILU(Suite *s, const Matrix *m, int threads, double *t, double *rhs, double *sol)
+{
+    void *handler, *ilu;
+    int *iparm, retval, r, k, i, runs, iterations;
+    double *dparm, analyze, rerr;
+
+    runs = s->warmup + s->repeat;
+    ilu = NULL;
+    retval = Prepare(m, threads, NULL, &handler, &iparm, &dparm, &analyze);
+    if (OK(retval))
+        retval = HypamasLevelILUInit(&ilu, 2);
+    if (FAIL(retval))
+    {
+        Record(s, m, threads, "level_ilu2", "gmres", t, 0, 0., 0., 0., 0, retval);
+        goto FINAL;
+    }
+    iparm[kIparmStagnationStep] = 25;
+
+    for (r = k = 0; r < runs; ++r)
+    {
+        t[k] = WallTime();
+        retval = HypamasLevelILUFactorize(ilu, m->n, m->ax, m->ap, m->ai, 0, threads);
+        t[k] = WallTime() - t[k];
+        if (FAIL(retval))
+            break;
+        if (r >= s->warmup)
+            ++k;
+    }
+    Record(s, m, threads, "level_ilu2", "infactorize", t, k, 0., 0., 0., 0, retval);
+    if (FAIL(retval))
+        goto FINAL;
+
+    iterations = 0;
+    for (r = k = 0; r < runs; ++r)
+    {
+        for (i = 0; i < m->n; ++i)
+            sol[i] = 0.;
+        t[k] = WallTime();
+        retval = HypamasLevelILUGMRES(handler, ilu, m->ax, m->ap, m->ai, rhs, sol, threads);
+        t[k] = WallTime() - t[k];
+        iterations = iparm[kIparmIterNum];
+        if (FAIL(retval))
+            break;
+        if (r >= s->warmup)
+            ++k;
+    }
+    rerr = 0.;
+    HypamasResidualNorm(handler, m->ax, m->ap, m->ai, sol, rhs, NULL, &rerr, NULL);
+    Record(s, m, threads, "level_ilu2", "gmres", t, k, 0., 0., rerr, iterations, retval);
+
+FINAL:
+
+    if (NULL != ilu)
+        HypamasLevelILUFinalize(ilu);
+    HypamasFinalize(handler);
+}
+
+// the path chosen by HypamasTune among the threads created, the iterations of the tune record are the paths timed
+static void RunTuned(Suite *s, const Matrix *m, int threads, double *t, double *rhs, double *sol)
+{
+    static const char *names[] = {"supernode", "column", "panel", "map"};
+    HypamasTuneResult tuned;
+    void *handler;
+    int *iparm, retval, r, k, runs;
+    double *dparm, analyze, memuse, rerr;
+    char kernel[64];
+
+    runs = s->warmup + s->repeat;
+    retval = Prepare(m, threads, NULL, &handler, &iparm, &dparm, &analyze);
+    if (OK(retval))
+    {
+        t[0] = WallTime();
+        retval = HypamasTune(handler, m->ax, m->ap, m->ai, s->cache, s->repeat, &tuned);
+        t[0] = WallTime() - t[0];
+    }
+    if (FAIL(retval))
+    {
+        Record(s, m, threads, "tuned", "tune", t, 0, 0., 0., 0., 0, retval);
+        HypamasFinalize(handler);
+        return;
+    }
+    snprintf(kernel, sizeof(kernel), "tuned_%s_t%d%s", names[tuned.kernel], tuned.threads, tuned.cached ? "_cached" : "");
+    Record(s, m, threads, kernel, "tune", t, 1, 0., 0., 0., tuned.candidates, retval);
+
+    for (r = k = 0; r < runs; ++r)
+    {
+        t[k] = WallTime();
+        retval = HypamasReFactorize(handler, m->ax, tuned.threads);
+        t[k] = WallTime() - t[k];
+        if (FAIL(retval))
+            break;
+        if (r >= s->warmup)
+            ++k;
+    }
+    HypamasEstimateMemoryUsage(handler, &memuse);
+    Record(s, m, threads, kernel, "refactorize", t, k, dparm[kDparmGFlopsAnalyzed], memuse, 0., 0, retval);
+    if (FAIL(retval))
+        goto FINAL;
+
+    for (r = k = 0; r < runs; ++r)
+    {
+        t[k] = WallTime();
+        retval = HypamasSolve(handler, rhs, sol, tuned.threads);
+        t[k] = WallTime() - t[k];
+        if (FAIL(retval))
+            break;
+        if (r >= s->warmup)
+            ++k;
+    }
+    rerr = 0.;
+    HypamasResidualNorm(handler, m->ax, m->ap, m->ai, sol, rhs, NULL, &rerr, NULL);
+    Record(s, m, threads, kernel, "solve", t, k, 0., memuse, rerr, 0, retval);
+
+FINAL:
+
+    HypamasFinalize(handler);
+}
+
+// a sequence of systems drifting from m as in the steps of a transient, solved by an ILUTP refreshed every step
+// and by the recycling GMRES keeping its subspace and factors, the iterations are the total of the sequence
+static void RunSequence(Suite *s, const Matrix *m, int threads, double *t, double *rhs, double *sol)
+{
+    void *handler, *recycle;
+    int *iparm, retval, r, i, p, runs, mode, iterations, refreshes;
+    long long total;
+    double *dparm, *ax, *b, analyze, rerr;
+    char kernel[64];
+
+    runs = s->warmup + s->repeat;
+    ax = (double *)malloc(sizeof(double) * m->nnz);
+    b = (double *)malloc(sizeof(double) * m->n);
+    for (mode = 0; mode < 2; ++mode)
+    {
+        recycle = NULL;
+        retval = Prepare(m, threads, NULL, &handler, &iparm, &dparm, &analyze);
+        if (OK(retval) && 1 == mode)
+            retval = HypamasRecycleInit(&recycle, 8, 0.);
+        snprintf(kernel, sizeof(kernel), 0 == mode ? "sequence_infactorize" : "sequence_recycle8");
+        if (FAIL(retval))
+        {
+            Record(s, m, threads, kernel, "sequence", t, 0, 0., 0., 0., 0, retval);
+            goto NEXT;
+        }
+        iparm[kIparmInFactAlgorithm] = kCfgInFactColumnSILUTP;
+        iparm[kIparmStagnationStep] = 25;
+
+        // every step scales the values by up to 1% more and moves the right hand side, the guess is the last solution
+        for (i = 0; i < m->n; ++i)
+            sol[i] = 0.;
+        total = 0;
+        for (r = 0; r < runs; ++r)
+        {
+            for (p = 0; p < m->nnz; ++p)
+                ax[p] = m->ax[p] * (1. + 0.01 * r * (double)((p * 2654435761u) >> 24) / 255.);
+            for (i = 0; i < m->n; ++i)
+                b[i] = rhs[i] * (1. + 0.01 * r);
+            t[r] = WallTime();
+            if (0 == mode)
+            {
+                retval = HypamasInFactorize(handler, ax, threads);
+                if (OK(retval))
+                    retval = HypamasGMRES(handler, ax, m->ap, m->ai, b, sol);
+            }
+            else
+                retval = HypamasRecycleGMRES(handler, recycle, ax, m->ap, m->ai, b, sol, threads);
+            t[r] = WallTime() - t[r];
+            if (FAIL(retval))
+                break;
+            total += iparm[kIparmIterNum];
+        }
+        rerr = 0.;
+        HypamasResidualNorm(handler, ax, m->ap, m->ai, sol, b, NULL, &rerr, NULL);
+        refreshes = r;
+        if (NULL != recycle)
+            HypamasRecycleInfo(recycle, NULL, NULL, &refreshes);
+        iterations = (int)total;
+        snprintf(kernel + strlen(kernel), sizeof(kernel) - strlen(kernel), "_refresh%d", refreshes);
+        Record(s, m, threads, kernel, "sequence", t, r, 0., 0., rerr, iterations, retval);
+
+    NEXT:
+
+        if (NULL != recycle)
+            HypamasRecycleFinalize(recycle);
+        HypamasFinalize(handler);
+    }
+    free(ax);
+    free(b);
+}
+
+// case c of a thread count: the kernels of the direct solver, the incomplete factorizations, the level ILU, the tuned path, then the sequence
+static void RunCase(Suite *s, const Matrix *m, int threads, int c, double *t, double *rhs, double *sol)
+{
+    if (c < KERNELS)
+        RunDirect(s, m, threads, g_kernels + c, t, rhs, sol);
+    else if (c < KERNELS + kCfgInFactSupernodeSILUTP)
+        RunIterative(s, m, threads, c - KERNELS + kCfgInFactColumnSILUTP, t, rhs, sol);
+    else if (c == KERNELS + kCfgInFactSupernodeSILUTP)
+        RunLevelILU(s, m, threads, t, rhs, sol);
+    else if (c == KERNELS + kCfgInFactSupernodeSILUTP + 1)
+        RunTuned(s, m, threads, t, rhs, sol);
+    else
+        RunSequence(s, m, threads, t, rhs, sol);
+}
+
+static void RunMatrix(Suite *s, const Matrix *m, const int *threads, int nthreads)
+{
+    double *t, *rhs, *sol;
+    int i, j, c, records, status;
+    pid_t pid;
+
+    t = (double *)malloc(sizeof(double) * (s->warmup + s->repeat + 1));
+    rhs = (double *)malloc(sizeof(double) * m->n * 2);
+    sol = rhs + m->n;
+
+    // a fixed right hand side which is not constant, so that cancellation does not hide errors
+    for (i = 0; i < m->n; ++i)
+        rhs[i] = 1. + (double)(i % 7) / 7.;
+
+    for (j = 0; j < nthreads; ++j)
+    {
+        for (c = 0; c < KERNELS + kCfgInFactSupernodeSILUTP + 3; ++c)
+        {
+            // every case runs in its own process from the same heap, so that one case can not change
+            // the timings of the next through the allocator, and a crash or timeout only loses that case
+            fflush(s->out);
+            pid = fork();
+            if (0 == pid)
+            {
+                records = s->records;
+                if (s->timeout > 0)
+                    alarm(s->timeout);
+                RunCase(s, m, threads[j], c, t, rhs, sol);
+                fflush(s->out);
+                _exit(s->records - records);
+            }
+            if (pid < 0)
+            {
+                RunCase(s, m, threads[j], c, t, rhs, sol);
+                continue;
+            }
+            if (waitpid(pid, &status, 0) == pid && WIFEXITED(status))
+                s->records += WEXITSTATUS(status);
+            else
+                fprintf(stderr, "%s with %d threads, case %d terminated\n", m->name, threads[j], c);
+        }
+    }
+
+    free(t);
+    free(rhs);
+}
+
+static int ParseList(const char *arg, int *list, int max)
+{
+    char *end;
+    int k;
+
+    for (k = 0; k < max && '\0' != *arg; ++k)
+    {
+        list[k] = (int)strtol(arg, &end, 10);
+        if (end == arg || list[k] <= 0)
+            return -1;
+        arg = ',' == *end ? end + 1 : end;
+    }
+    return k;
+}
+
+// .mtx and .csr files of a directory, sorted by name so that the order is reproducible
+static int ListDirectory(const char *dir, char **files, int count)
+{
+    DIR *d;
+    struct dirent *ent;
+    size_t len;
+    int first, i, j;
+    char *tmp;
+
+    d = opendir(dir);
+    if (NULL == d)
+        return count;
+    first = count;
+    while (count < MAX_MATRICES && NULL != (ent = readdir(d)))
+    {
+        len = strlen(ent->d_name);
+        if (len <= 4 || (0 != strcmp(ent->d_name + len - 4, ".mtx") && 0 != strcmp(ent->d_name + len - 4, ".csr")))
+            continue;
+        files[count] = (char *)malloc(strlen(dir) + len + 2);
+        sprintf(files[count], "%s/%s", dir, ent->d_name);
+        ++count;
+    }
+    closedir(d);
+
+    for (i = first + 1; i < count; ++i)
+    {
+        tmp = files[i];
+        for (j = i - 1; j >= first && strcmp(files[j], tmp) > 0; --j)
+            files[j + 1] = files[j];
+        files[j + 1] = tmp;
+    }
+    return count;
+}
+
+static void Usage(void)
+{
+    printf("usage: benchmark_suite [-t threads,...] [-w warmup] [-r repeat] [-g size,...] [-T seconds] [-c cache] [-f csv|json] [-o file] [matrix|directory ...]\n");
+    printf("  -t  thread counts to sweep, default 1\n");
+    printf("  -w  runs not measured before each phase, default 1\n");
+    printf("  -r  runs measured for the median & 95th percentile, default 5\n");
+    printf("  -g  sizes of generated circuit-like matrices\n");
+    printf("  -T  time limit of one case, default 600, 0 for none\n");
+    printf("  -c  tuning cache file of HypamasTune, none by default\n");
+    printf("  -f  output format, default csv\n");
+    printf("  -o  output file, default stdout\n");
+}
+
+int main(int argc, char *argv[])
+{
+    Suite s;
+    Matrix m;
+    char *files[MAX_MATRICES];
+    int threads[MAX_THREADS], sizes[MAX_MATRICES];
+    int nthreads, nsizes, nfiles, i, retval;
+    const char *output;
+    DIR *d;
+
+    s.warmup = 1;
+    s.repeat = 5;
+    s.json = 0;
+    s.timeout = 600;
+    s.cache = NULL;
+    s.records = 0;
+    threads[0] = 1;
+    nthreads = 1;
+    nsizes = 0;
+    nfiles = 0;
+    output = NULL;
+
+    for (i = 1; i < argc; ++i)
+    {
+        if ('-' == argv[i][0] && i + 1 < argc)
+        {
+            switch (argv[i][1])
+            {
+            case 't':
+                nthreads = ParseList(argv[++i], threads, MAX_THREADS);
+                break;
+            case 'g':
+                nsizes = ParseList(argv[++i], sizes, MAX_MATRICES);
+                break;
+            case 'c':
+                s.cache = argv[++i];
+                break;
+            case 'T':
+                s.timeout = atoi(argv[++i]);
+                break;
+            case 'w':
+                s.warmup = atoi(argv[++i]);
+                break;
+            case 'r':
+                s.repeat = atoi(argv[++i]);
+                break;
+            case 'f':
+                s.json = 0 == strcmp(argv[++i], "json");
+                break;
+            case 'o':
+                output = argv[++i];
+                break;
+            default:
+                Usage();
+                return 1;
+            }
+        }
+        else if ('-' == argv[i][0])
+        {
+            Usage();
+            return 1;
+        }
+        else
+        {
+            d = opendir(argv[i]);
+            if (NULL != d)
+            {
+                closedir(d);
+                nfiles = ListDirectory(argv[i], files, nfiles);
+            }
+            else if (nfiles < MAX_MATRICES)
+            {
+                files[nfiles++] = strdup(argv[i]);
+            }
+        }
+    }
+    if (nthreads <= 0 || nsizes < 0 || s.warmup < 0 || s.repeat <= 0 || s.timeout < 0 || (0 == nfiles && 0 == nsizes))
+    {
+        Usage();
+        return 1;
+    }
+
+    s.out = NULL != output ? fopen(output, "w") : stdout;
+    if (NULL == s.out)
+    {
+        printf("open output file error\n");
+        return 1;
+    }
+    if (s.json)
+        fprintf(s.out, "[");
+
+    // generated matrices first, the same seed gives the same matrix on every machine
+    for (i = 0; i < nsizes; ++i)
+    {
+        GenerateCircuit(sizes[i], 20220318u + (unsigned int)sizes[i], &m);
+        RunMatrix(&s, &m, threads, nthreads);
+        FreeMatrix(&m);
+    }
+    for (i = 0; i < nfiles; ++i)
+    {
+        retval = LoadMatrix(files[i], &m);
+        if (FAIL(retval))
+            fprintf(stderr, "read matrix %s error = %d\n", files[i], retval);
+        else
+        {
+            RunMatrix(&s, &m, threads, nthreads);
+            FreeMatrix(&m);
+        }
+        free(files[i]);
+    }
+
+    if (s.json)
+        fprintf(s.out, "\n]\n");
+    if (s.out != stdout)
+        fclose(s.out);
+
+    return 0;
+}
@@ -0,0 +1,581 @@
+/*used to define extension api built on top of libhypamas*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#ifndef __HYPAMAS_EXT__
+#define __HYPAMAS_EXT__
+
+#include <stddef.h>
+#include "hypamas_api.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /*Refactorize count handlers analyzed from matrices of the same pattern, handlers[i] with values ax[i].*/
+    /*The handlers are scheduled over threads, each one refactorized by max(1, threads/count) threads. If threads <= 0, the number of threads created by HypamasInitThreads of handlers[0] is used.*/
+    /*If status is not NULL, status[i] returns the value of handlers[i]. The first failure by index is returned, otherwise the last warning.*/
+    int HypamasBatchReFactorize(
+        INOUT__ void **handlers,
+        IN__ int count,
+        IN__ double **ax,
+        IN__ int threads,
+        OUT__ int *status);
+
+    /*Solve count systems of handlers refactorized by HypamasBatchReFactorize, handlers[i] with rhs[i] & sol[i], see HypamasSolve.*/
+    /*sol may be NULL, or sol[i] may be NULL, then rhs[i] is overwritten by the solution. For threads and status, see HypamasBatchReFactorize.*/
+    int HypamasBatchSolve(
+        INOUT__ void **handlers,
+        IN__ int count,
+        INOUT__ double **rhs,
+        OUT__ double **sol,
+        IN__ int threads,
+        OUT__ int *status);
+
+    /*Non-blocking versions of HypamasFactorize, HypamasReFactorize & HypamasSolve, run by a background worker in the order of submission.*/
+    /*request returns a handle for HypamasWait or HypamasTest. Until then, the handler must not be used by blocking routines and the arrays must be kept.*/
+    /*If values is not NULL, ax is ignored and the array last returned by HypamasValueBufferNext of values is factorized.*/
+    int HypamasFactorizeAsync(
+        INOUT__ void *handler,
+        IN__ double *ax,
+        IN__ void *values,
+        IN__ int threads,
+        OUT__ void **request);
+
+    int HypamasReFactorizeAsync(
+        INOUT__ void *handler,
+        IN__ double *ax,
+        IN__ void *values,
+        IN__ int threads,
+        OUT__ void **request);
+
+    int HypamasSolveAsync(
+        INOUT__ void *handler,
+        INOUT__ double *rhs,
+        OUT__ double *sol,
+        IN__ int threads,
+        OUT__ void **request);
+
+    /*Refactorize, solve and, if residual is not NULL, compute |b-A*x| in L2-norm as one request, the stages follow each other on the worker.*/
+    /*With residual, sol must not be NULL and ap & ai give the pattern of ax. The first failing stage ends the request.*/
+    int HypamasReFactorizeSolveAsync(
+        INOUT__ void *handler,
+        IN__ double *ax,
+        IN__ void *values,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ double *rhs,
+        OUT__ double *sol,
+        OUT__ double *residual,
+        IN__ int threads,
+        OUT__ void **request);
+
+    /*Block until the request is done, return its value and release it, *request is set to NULL.*/
+    int HypamasWait(
+        INOUT__ void **request);
+
+    /*Return at once, done tells if the request is done. If so, its value is returned and it is released as by HypamasWait.*/
+    int HypamasTest(
+        INOUT__ void **request,
+        OUT__ int *done);
+
+    /*Double buffer of nnz values for the asynchronous factorizations, the caller stamps one array while the other is factorized.*/
+    int HypamasValueBufferCreate(
+        OUT__ void **values,
+        IN__ int nnz);
+
+    /*Array to stamp the next values into, the two arrays are returned in turn. It blocks while a factorization submitted with it is not done.*/
+    int HypamasValueBufferNext(
+        INOUT__ void *values,
+        OUT__ double **ax);
+
+    /*Free a double buffer, waiting for the factorizations still reading it.*/
+    int HypamasValueBufferFree(
+        INOUT__ void *values);
+
+    /*Parallel version of HypamasGMRES running the Arnoldi process on threads, see kIparmGMRESOrthogonalization.*/
+    /*If threads <= 0, the number of threads created by HypamasInitThreads is used. On input sol is the initial guess.*/
+    /*Before called, HypamasInFactorize must be called unless the preconditioner is off.*/
+    /*With kIparmSolveTranspose, ax, ap & ai are the CSC of A as given to HypamasAnalyze, the values are read in place.*/
+    int HypamasParallelGMRES(
+        INOUT__ void *handler,
+        IN__ double *ax,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ double *rhs,
+        INOUT__ double *sol,
+        IN__ int threads);
+
+    /*Create an ILU(k) preconditioner applied with level-scheduled triangular solves, k = fill is the level of fill.*/
+    int HypamasLevelILUInit(
+        OUT__ void **ilu,
+        IN__ int fill);
+
+    /*Select the precision of the factors used from the next HypamasLevelILUFactorize, see HypamasCfgILUPrecision.*/
+    /*Single precision halves the memory of the factors. HypamasLevelILUGMRES recovers double accuracy and falls back to double factors if it stalls,*/
+    /*those are kept until the next HypamasLevelILUFactorize or HypamasLevelILUPartialFactorize, which factorizes in the precision selected here again.*/
+    int HypamasLevelILUSetPrecision(
+        INOUT__ void *ilu,
+        IN__ int precision);
+
+    /*Select how HypamasLevelILUFactorize schedules the rows over threads, see HypamasCfgILUSchedule.*/
+    int HypamasLevelILUSetSchedule(
+        INOUT__ void *ilu,
+        IN__ int schedule);
+
+    /*Make the preconditioner the complete LU of P*A if exact is not zero: the analysis raises the level of fill to n, and a pivot below the guard*/
+    /*fails HypamasLevelILUFactorize & HypamasLevelILUPartialFactorize by kErrorMatrixNumericSingular instead of being perturbed. A current analysis of a lower level is dropped.*/
+    /*An analysis loaded from a file of a lower level fails the factorization by kErrorMatrixConsistencyCheck. The factors are exact up to the rounding of their precision.*/
+    int HypamasLevelILUSetExact(
+        INOUT__ void *ilu,
+        IN__ int exact);
+
+    /*Free the memory used by the preconditioner.*/
+    int HypamasLevelILUFinalize(
+        IN__ void *ilu);
+
+    /*ILU(k) of A with rows permuted to a zero-free diagonal. For mode, see Hypamas_ReadMatrixMarketFile.*/
+    /*The permutation, the pattern of the factors and the level sets are computed at the first call, later calls must keep the pattern and only refactorize values.*/
+    /*The levels are scheduled over threads when they are wide enough, otherwise or if threads <= 1 it runs sequentially.*/
+    int HypamasLevelILUFactorize(
+        INOUT__ void *ilu,
+        IN__ int n,
+        IN__ double *ax,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ int mode,
+        IN__ int threads);
+
+    /*Refactorize after only the entries ax[changed[0..nchanged-1]] have changed, positions in ap & ai given to HypamasLevelILUFactorize.*/
+    /*Only the rows of the factors holding a changed entry and the rows depending on them are recomputed, the others are kept.*/
+    /*If updated is not NULL, it returns the number of rows recomputed. The result is the same as HypamasLevelILUFactorize.*/
+    /*After HypamasLevelILUSetPrecision changed the precision, all rows are recomputed.*/
+    int HypamasLevelILUPartialFactorize(
+        INOUT__ void *ilu,
+        IN__ double *ax,
+        IN__ int *changed,
+        IN__ int nchanged,
+        IN__ int threads,
+        OUT__ int *updated);
+
+    /*Apply the preconditioner, sol = inv(LU)*P*rhs. If sol is NULL, rhs will be overwritten by the result.*/
+    int HypamasLevelILUSolve(
+        IN__ void *ilu,
+        INOUT__ double *rhs,
+        OUT__ double *sol,
+        IN__ int threads);
+
+    /*Apply the preconditioner to a sparse rhs with nz entries val at rows idx, sol[i] returns the entry out[i] of inv(LU)*P*rhs.*/
+    /*Only the rows reached from idx through L and from out through U are visited. The reach sets are cached and reused while idx and out repeat.*/
+    /*If reach is not NULL, reach[0] & reach[1] return the number of rows visited by the forward and backward substitution.*/
+    /*The factors are incomplete by default, the entries are those of the preconditioner and only approximate inv(A)*rhs. See HypamasLevelILUSetExact for exact entries.*/
+    int HypamasLevelILUSparseSolve(
+        IN__ void *ilu,
+        IN__ int nz,
+        IN__ int *idx,
+        IN__ double *val,
+        IN__ int nout,
+        IN__ int *out,
+        OUT__ double *sol,
+        OUT__ int *reach);
+
+    /*Write the analysis of the preconditioner(row permutation, pattern of the factors and level sets) to a versioned binary file.*/
+    /*ap & ai are the pattern given to HypamasLevelILUFactorize, a checksum of them is stored in the file.*/
+    int HypamasLevelILUSaveAnalysis(
+        IN__ void *ilu,
+        IN__ char *file,
+        IN__ int *ap,
+        IN__ int *ai);
+
+    /*Map a file written by HypamasLevelILUSaveAnalysis, then HypamasLevelILUFactorize only refactorizes values.*/
+    /*kErrorMatrixConsistencyCheck is returned if n, the pattern or mode does not match the file. The file is in native byte order.*/
+    /*kErrorOpenFileFail is returned if the file is not an analysis or any index stored in it is out of bounds.*/
+    int HypamasLevelILULoadAnalysis(
+        INOUT__ void *ilu,
+        IN__ char *file,
+        IN__ int n,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ int mode);
+
+    /*Same as HypamasParallelGMRES but preconditioned by the level-scheduled ILU(k) instead of the factors of the handler.*/
+    /*Only HypamasAnalyze is required before called. ilu must be factorized from the same matrix, in CSC mode if kIparmSolveTranspose is set.*/
+    /*If the factors are in single precision and the iteration does not converge, ilu is refactorized in double and the iteration restarts from sol.*/
+    int HypamasLevelILUGMRES(
+        INOUT__ void *handler,
+        IN__ void *ilu,
+        IN__ double *ax,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ double *rhs,
+        INOUT__ double *sol,
+        IN__ int threads);
+
+    /*ILU(k) of count matrices with the same pattern sharing one analysis, ax[i] are the values of the i-th matrix.*/
+    /*The analysis is computed from ax[0] if the preconditioner is not analyzed yet. The values are interleaved by matrix so that the kernels run over matrices in the innermost loop.*/
+    /*The levels are scheduled over threads when they are wide enough, otherwise the matrices are.*/
+    int HypamasLevelILUBatchFactorize(
+        INOUT__ void *ilu,
+        IN__ int n,
+        IN__ int count,
+        IN__ double **ax,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ int mode,
+        IN__ int threads);
+
+    /*Apply the count preconditioners of HypamasLevelILUBatchFactorize, sol[i] = inv(L_i*U_i)*P*rhs[i]. sol[i] may be rhs[i].*/
+    int HypamasLevelILUBatchSolve(
+        IN__ void *ilu,
+        IN__ double **rhs,
+        OUT__ double **sol,
+        IN__ int threads);
+
+    /*******************************************************************************/
+
+    /*Dense matrix-matrix multiplication C = alpha*A*B + beta*C, A is m-by-k, B is k-by-n, all column-major.*/
+    /*The register-tiled micro kernel is selected by CPUID at the first call, see Hypamas_SelectDgemmKernel.*/
+    int Hypamas_dgemm(
+        IN__ int m,
+        IN__ int n,
+        IN__ int k,
+        IN__ double alpha,
+        IN__ double *a,
+        IN__ int lda,
+        IN__ double *b,
+        IN__ int ldb,
+        IN__ double beta,
+        INOUT__ double *c,
+        IN__ int ldc);
+
+    /*Dense triangular solve B = inv(A)*B, A is m-by-m lower or upper triangular, B is m-by-n, all column-major.*/
+    /*For uplo, see HypamasUplo. For diag, see HypamasDiag.*/
+    int Hypamas_dtrsm(
+        IN__ int uplo,
+        IN__ int diag,
+        IN__ int m,
+        IN__ int n,
+        IN__ double *a,
+        IN__ int lda,
+        INOUT__ double *b,
+        IN__ int ldb);
+
+    /*Force the micro kernel used by Hypamas_dgemm, see HypamasDgemmKernel. It is not allowed to call it concurrently with Hypamas_dgemm.*/
+    /*kErrorAlgorithmInvalid is returned if the processor does not support the instruction set of the kernel.*/
+    int Hypamas_SelectDgemmKernel(
+        IN__ int kernel);
+
+    /*Name of the micro kernel used by Hypamas_dgemm.*/
+    const char *Hypamas_DgemmKernelName(void);
+
+    /*The parallel routines of the extension share one process-wide pool of threads, separate from the threads of HypamasInitThreads.*/
+    /*Idle threads spin for spin pause rounds(default 4000) waiting for work or at a barrier, then sleep on a futex until woken.*/
+    int Hypamas_SetThreadPoolSpin(
+        IN__ int spin);
+
+    /*Let the threads of the pool sleep without spinning between parallel regions, e.g. while the caller evaluates devices.*/
+    /*The next parallel region still wakes them. Hypamas_UnparkThreadPool restores spinning and wakes them ahead of the next region.*/
+    int Hypamas_ParkThreadPool(void);
+
+    int Hypamas_UnparkThreadPool(void);
+
+    /*Average & maximum time in seconds from the start of a parallel region until a thread of the pool joins it, reset to zero if reset is not zero.*/
+    int Hypamas_ThreadPoolWakeLatency(
+        OUT__ double *average,
+        OUT__ double *maximum,
+        IN__ int reset);
+
+    /*Trace of the extension: calls, time & estimated flops of each phase(HypamasTracePhase), and busy & wait time and tasks of each thread of the pool.*/
+    /*Start it with a timeline of up to events intervals per thread, 0 for the counters only, then read it by Hypamas_TraceStats or export the timeline.*/
+    /*While stopped each traced routine costs one load. Hypamas_TraceStart frees no buffer of another thread, each thread restarts its own counters & timeline on its next record.*/
+    /*Call Hypamas_TraceStats & Hypamas_TraceExport while no other routine of the extension runs.*/
+    typedef struct HypamasTraceStats HypamasTraceStats;
+
+    int Hypamas_TraceStart(
+        IN__ int events);
+
+    int Hypamas_TraceStop(void);
+
+    int Hypamas_TraceStats(
+        OUT__ HypamasTraceStats *stats);
+
+    /*Write the timeline to a JSON file in the Chrome trace event format, opened by chrome://tracing or Perfetto.*/
+    int Hypamas_TraceExport(
+        IN__ char *file);
+
+    /*Time the refactorization & solving paths of an analyzed handler(HypamasTuneKernel over 1, 2, 4... up to the threads created) and keep the fastest.*/
+    /*A thread count is skipped when even a perfect speedup of the sequential time can not win, and more threads are not tried once they stop paying off.*/
+    /*On return the handler is factorized from ax on the winning path with kIparmAutoParallelOff set, result->threads is the count to give to HypamasReFactorize & HypamasSolve.*/
+    /*cache is a text file of tuned patterns keyed by the checksum of ap & ai, if it holds the pattern for the threads created the path is applied without timing. NULL for none.*/
+    /*rounds is the number of timed refactorizations of a path, 5 if <= 0. If the cache can not be written, kErrorOpenFileFail is returned and the handler is still tuned.*/
+    /*If every path fails, kIparmAutoParallelOff and the kernel settings of the caller are restored, the handler is factorized with them and the error is returned.*/
+    typedef struct HypamasTuneResult HypamasTuneResult;
+
+    int HypamasTune(
+        INOUT__ void *handler,
+        IN__ double *ax,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ char *cache,
+        IN__ int rounds,
+        OUT__ HypamasTuneResult *result);
+
+    /*State of GMRES solving a sequence of systems of one analyzed handler, keeping up to k corrections as a recycled subspace(GCRO) and the preconditioner factors.*/
+    /*k is 0 for the reuse of the factors only. The factors are refreshed by HypamasInFactorize when the iterations exceed ratio(2 if <= 0) times those of the first solve after the last refresh.*/
+    int HypamasRecycleInit(
+        OUT__ void **recycle,
+        IN__ int k,
+        IN__ double ratio);
+
+    int HypamasRecycleFinalize(
+        IN__ void *recycle);
+
+    /*Solve A*x = b of the sequence from the initial guess sol, with kIparmKrylovDimension, kIparmKrylovMaxIter, kIparmStagnationStep & kDparmGMRESMetricTolerance of the handler.*/
+    /*The preconditioner is kIparmInFactAlgorithm, factorized here if the handler is not factorized yet. After a solve ending in a warning on old factors, they are refreshed from ax and the solve goes on.*/
+    /*The recycled subspace follows new values of ax. kIparmIterNum is the iterations of the call. threads is for HypamasInFactorize & HypamasSolve, kIparmThreadCreated if <= 0.*/
+    int HypamasRecycleGMRES(
+        INOUT__ void *handler,
+        INOUT__ void *recycle,
+        IN__ double *ax,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ double *rhs,
+        INOUT__ double *sol,
+        IN__ int threads);
+
+    /*Dimension of the recycled subspace, and iterations & refreshes of the factors over the sequence. NULL for any not wanted.*/
+    int HypamasRecycleInfo(
+        IN__ void *recycle,
+        OUT__ int *dimension,
+        OUT__ long long *iterations,
+        OUT__ int *refreshes);
+
+    /*Allocator callbacks of the extension, user is the pointer given to Hypamas_SetAllocator.*/
+    typedef void *(*HypamasAllocProc)(size_t size, void *user);
+    typedef void *(*HypamasResizeProc)(void *ptr, size_t size, void *user);
+    typedef void (*HypamasReleaseProc)(void *ptr, void *user);
+
+    /*Route the memory of the extension(preconditioners, workspaces & scratch arenas) to the callbacks, all NULL restores malloc & free.*/
+    /*Call it before creating any object of the extension or after all are freed. Memory of libhypamas itself, the process-wide thread pool and arrays returned to the caller are not affected.*/
+    int Hypamas_SetAllocator(
+        IN__ HypamasAllocProc alloc,
+        IN__ HypamasResizeProc resize,
+        IN__ HypamasReleaseProc release,
+        IN__ void *user);
+
+    /*Built-in callbacks for Hypamas_SetAllocator, blocks from 1MB are mapped on huge pages, transparent ones if none are reserved.*/
+    void *Hypamas_HugePageAlloc(
+        IN__ size_t size,
+        IN__ void *user);
+
+    void *Hypamas_HugePageResize(
+        IN__ void *ptr,
+        IN__ size_t size,
+        IN__ void *user);
+
+    void Hypamas_HugePageRelease(
+        IN__ void *ptr,
+        IN__ void *user);
+
+    /*Each thread keeps a scratch arena for the workspaces of a call, it grows to the peak of the calls so far and is then reused without allocation.*/
+    /*Reserve size bytes for the arena of the calling thread ahead of the first call, e.g. after the analysis.*/
+    int Hypamas_ReserveScratch(
+        IN__ size_t size);
+
+    /*Number of heap allocations made by the extension so far, a steady state leaves it unchanged.*/
+    int Hypamas_AllocationCount(
+        OUT__ long long *count);
+
+    /*Read a matrix market file mapped and parsed in chunks by threads, ax & ap & ai are based zero. If ap is NULL and ai is NULL, ax is a dense vector.*/
+    /*If mode is zero, ap is compressed by the column index of the file entries and ai holds their row index, otherwise ap is compressed by the row index and ai holds the column.*/
+    /*Indices are sorted within each compressed row or column and duplicated entries are summed. The mirror of every off-diagonal entry of a symmetric or*/
+    /*skew-symmetric file is added(negated for skew) and the values of a pattern file are 1., ap[n] counts the distinct entries after this expansion.*/
+    /*The result differs from Hypamas_ReadMatrixMarketFile for mode != 0 and for symmetric & pattern files, which that reader does not expand.*/
+    /*The arrays are allocated by malloc. If threads <= 0, one thread is used.*/
+    int Hypamas_ReadMatrixMarketFileParallel(
+        IN__ char *file,
+        OUT__ int *n,
+        OUT__ int *nnz,
+        OUT__ double **ax,
+        OUT__ int **ap,
+        OUT__ int **ai,
+        IN__ int mode,
+        IN__ int threads);
+
+    /*Write a matrix to the binary format read by Hypamas_MapBinaryMatrixFile, for mode, see Hypamas_ReadMatrixMarketFile.*/
+    int Hypamas_WriteBinaryMatrixFile(
+        IN__ char *file,
+        IN__ int n,
+        IN__ int nnz,
+        IN__ double *ax,
+        IN__ int *ap,
+        IN__ int *ai,
+        IN__ int mode);
+
+    /*Map a binary matrix file without copy, ax & ap & ai point into the mapping and can be given to HypamasAnalyze directly.*/
+    /*mode is the format stored in the file. The mapping is private, writes are not carried to the file.*/
+    int Hypamas_MapBinaryMatrixFile(
+        IN__ char *file,
+        OUT__ int *n,
+        OUT__ int *nnz,
+        OUT__ double **ax,
+        OUT__ int **ap,
+        OUT__ int **ai,
+        OUT__ int *mode,
+        OUT__ void **map);
+
+    /*Release a mapping returned by Hypamas_MapBinaryMatrixFile.*/
+    int Hypamas_UnmapBinaryMatrixFile(
+        IN__ void *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief Integer control parameters of the extension, stored in the tail of iparm unused by libhypamas
+ */
+enum HypamasExtIparm
+{
+    kIparmGMRESOrthogonalization = 48, /* Orthogonalization of HypamasParallelGMRES                        Default: kCfgGMRESOrthAuto                  [IN]        */
+};
+
+/**
+ * @brief Real control parameters of the extension, stored in the tail of dparm unused by libhypamas
+ */
+enum HypamasExtDparm
+{
+    kDparmThreadWakeLatency = 48, /* Average wake-up latency of the thread pool in the last solving, seconds Default: -                           [OUT]       */
+};
+
+/**
+ * @brief Phases of the trace of the extension, see Hypamas_TraceStart
+ */
+enum HypamasTracePhase
+{
+    kTracePhaseRegion = 0,       /* A thread running a parallel region of the pool*/
+    kTracePhaseWait = 1,         /* A thread of a region waiting at a barrier, for the other threads or for ready tasks*/
+    kTracePhaseTranspose = 2,    /* Parallel transpose of a pattern*/
+    kTracePhaseILUAnalyze = 3,   /* Matching, fill & level sets of the level ILU(k)*/
+    kTracePhaseILUFactorize = 4, /* Numeric factorization of the level ILU(k), flops estimated from the pattern*/
+    kTracePhaseILUSolve = 5,     /* Triangular solves of the level ILU(k)*/
+    kTracePhaseGMRES = 6,        /* Parallel GMRES, flops of the SpMV & orthogonalization*/
+    kTracePhaseBatch = 7,        /* Batch refactorization or solving of handlers*/
+    kTracePhaseAsync = 8,        /* Request run by the asynchronous worker*/
+    kTracePhaseCount = 9,
+};
+
+#define HYPAMAS_TRACE_MAX_THREADS 64 /* threads traced, the others are not recorded */
+
+/**
+ * @brief Counters of one phase of the trace
+ */
+typedef struct
+{
+    long long calls;
+    double time;  /* seconds, summed over threads */
+    double flops; /* estimated floating-point operations */
+} HypamasTracePhaseStats;
+
+/**
+ * @brief Counters of one thread of the trace
+ */
+typedef struct
+{
+    double busy;       /* seconds running regions, waits excluded */
+    double wait;       /* seconds waiting inside regions */
+    long long regions; /* regions joined */
+    long long tasks;   /* nodes run by the work-stealing executor */
+} HypamasTraceThreadStats;
+
+struct HypamasTraceStats
+{
+    HypamasTracePhaseStats phase[kTracePhaseCount];
+    HypamasTraceThreadStats thread[HYPAMAS_TRACE_MAX_THREADS]; /* by trace slot, the calling thread of the first region usually first */
+    int threads;       /* threads recorded */
+    long long events;  /* intervals in the timelines */
+    long long dropped; /* intervals lost to full timelines */
+};
+
+/**
+ * @brief Refactorization paths timed by HypamasTune, selected through iparm of libhypamas
+ */
+enum HypamasTuneKernel
+{
+    kTuneKernelSupernode = 0, /* Supernodes & panels as set by the caller*/
+    kTuneKernelColumn = 1,    /* Column kernel, kIparmSupernodeMinColumn above n*/
+    kTuneKernelPanel = 2,     /* Supernodes with twice kIparmPanelSize*/
+    kTuneKernelMap = 3,       /* Supernodes refactorized by the map link, kIparmMapLinkOff cleared*/
+};
+
+struct HypamasTuneResult
+{
+    int kernel;         /* HypamasTuneKernel */
+    int threads;        /* threads of the winning path */
+    int cached;         /* non-zero if read from the cache without timing */
+    int candidates;     /* paths timed */
+    double refactorize; /* median seconds of a refactorization */
+    double solve;       /* median seconds of a solving */
+    double gflops;      /* analyzed flops over refactorize */
+};
+
+/**
+ * @brief Orthogonalization of the parallel GMRES
+ */
+enum HypamasCfgGMRESOrth
+{
+    kCfgGMRESOrthAuto = 0,         /* MGS for one thread, otherwise single reduction*/
+    kCfgGMRESOrthMGS = 1,          /* Modified Gram-Schmidt, one reduction per basis vector*/
+    kCfgGMRESOrthCGS2 = 2,         /* Classical Gram-Schmidt with reorthogonalization, two reductions per iteration*/
+    kCfgGMRESOrthSingleReduce = 3, /* Classical Gram-Schmidt with fused Pythagorean norm, one reduction per iteration*/
+};
+
+/**
+ * @brief Precision of the factors of the level ILU(k), see HypamasLevelILUSetPrecision
+ */
+enum HypamasCfgILUPrecision
+{
+    kCfgILUPrecisionDouble = 0, /* Factorized and stored in double*/
+    kCfgILUPrecisionSingle = 1, /* Factorized and stored in single, applied with double accumulation*/
+};
+
+/**
+ * @brief Scheduling of the factorization of the level ILU(k), see HypamasLevelILUSetSchedule
+ */
+enum HypamasCfgILUSchedule
+{
+    kCfgILUScheduleLevel = 0, /* Rows of each level split over threads with a barrier between levels, sequential if the levels are thin*/
+    kCfgILUScheduleSteal = 1, /* Rows run once their dependencies are done, idle threads steal ready rows from the others*/
+};
+
+/**
+ * @brief Triangular part referenced by Hypamas_dtrsm
+ */
+enum HypamasUplo
+{
+    kUploLower = 0, /* Lower triangular*/
+    kUploUpper = 1, /* Upper triangular*/
+};
+
+/**
+ * @brief Diagonal referenced by Hypamas_dtrsm
+ */
+enum HypamasDiag
+{
+    kDiagNonUnit = 0, /* Diagonal is stored in the matrix*/
+    kDiagUnit = 1,    /* Diagonal is assumed to be one*/
+};
+
+/**
+ * @brief Micro kernel of Hypamas_dgemm
+ */
+enum HypamasDgemmKernel
+{
+    kDgemmKernelAuto = 0,    /* Best kernel supported by CPUID*/
+    kDgemmKernelGeneric = 1, /* Portable 4x4 kernel*/
+    kDgemmKernelAVX2 = 2,    /* 8x6 kernel using AVX2 & FMA*/
+    kDgemmKernelAVX512 = 3,  /* 16x8 kernel using AVX-512F*/
+};
+
+#endif
@@ -0,0 +1,302 @@
+/*used to save and map the symbolic analysis of the extension*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hypamas_ext_internal.h"
+
+#define _ANALYSIS_MAGIC "HYPAILU"
+#define _ANALYSIS_VERSION 1
+#define _ANALYSIS_ARRAYS 9
+
+/**
+ * @brief Header of the analysis file, followed by the arrays at 8-byte aligned offsets.
+ * Native byte order, the file is only valid on the same architecture.
+ */
+typedef struct
+{
+    char magic[8];
+    int version;
+    int header; /* size of the header in bytes */
+    int n;
+    int nnz;   /* non-zeros of A */
+    int lunnz; /* non-zeros of L\U */
+    int fill;
+    int mode;
+    int lnum;
+    int unum;
+    int reserved;
+    unsigned long long checksum;        /* of the pattern of A */
+    long long offset[_ANALYSIS_ARRAYS]; /* perm, map, bp, bi, diag, lptr, lrows, uptr, urows */
+} _HypamasAnalysisHeader;
+
+unsigned long long _HypamasPatternChecksum(
+    IN__ int n,
+    IN__ const int *ap,
+    IN__ const int *ai)
+{
+    unsigned long long h;
+    int i;
+
+    /*FNV-1a over 32-bit words*/
+    h = 14695981039346656037ULL;
+    h = (h ^ (unsigned int)n) * 1099511628211ULL;
+    for (i = 0; i <= n; ++i)
+        h = (h ^ (unsigned int)ap[i]) * 1099511628211ULL;
+    for (i = ap[0]; i < ap[n]; ++i)
+        h = (h ^ (unsigned int)ai[i]) * 1099511628211ULL;
+
+    return h;
+}
+
+static void _AnalysisArrays(const _HypamasAnalysisHeader *head, long long *count)
+{
+    count[0] = head->n;
+    count[1] = head->lunnz;
+    count[2] = head->n + 1;
+    count[3] = head->lunnz;
+    count[4] = head->n;
+    count[5] = head->lnum + 1;
+    count[6] = head->n;
+    count[7] = head->unum + 1;
+    count[8] = head->n;
+}
+
+/*entries of a[0..count-1] in [lo, hi)*/
+static int _AnalysisInRange(const int *a, long long count, int lo, int hi)
+{
+    long long i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (a[i] < lo || a[i] >= hi)
+            return 0;
+    }
+    return 1;
+}
+
+/*ptr[0..count] ascends from 0 to last*/
+static int _AnalysisPointers(const int *ptr, int count, int last)
+{
+    int i;
+
+    if (0 != ptr[0] || last != ptr[count])
+        return 0;
+    for (i = 0; i < count; ++i)
+    {
+        if (ptr[i] > ptr[i + 1])
+            return 0;
+    }
+    return 1;
+}
+
+/*The mapped arrays are indexed by the numeric phase without checks, so a truncated or corrupted payload*/
+/*behind a valid header must be rejected here. Returns 0 if an index is out of its bounds.*/
+static int _AnalysisValid(const _HypamasAnalysisHeader *head, const char *base)
+{
+    const int *perm, *map, *bp, *bi, *diag, *lptr, *lrows, *uptr, *urows;
+    int n, k;
+
+    n = head->n;
+    perm = (const int *)(base + head->offset[0]);
+    map = (const int *)(base + head->offset[1]);
+    bp = (const int *)(base + head->offset[2]);
+    bi = (const int *)(base + head->offset[3]);
+    diag = (const int *)(base + head->offset[4]);
+    lptr = (const int *)(base + head->offset[5]);
+    lrows = (const int *)(base + head->offset[6]);
+    uptr = (const int *)(base + head->offset[7]);
+    urows = (const int *)(base + head->offset[8]);
+
+    if (!_AnalysisInRange(perm, n, 0, n) || !_AnalysisPointers(bp, n, head->lunnz) ||
+        !_AnalysisInRange(bi, head->lunnz, 0, n) || !_AnalysisInRange(map, head->lunnz, -1, head->nnz) ||
+        !_AnalysisPointers(lptr, head->lnum, n) || !_AnalysisInRange(lrows, n, 0, n) ||
+        !_AnalysisPointers(uptr, head->unum, n) || !_AnalysisInRange(urows, n, 0, n))
+        return 0;
+    for (k = 0; k < n; ++k)
+    {
+        if (diag[k] < bp[k] || diag[k] >= bp[k + 1] || k != bi[diag[k]])
+            return 0;
+    }
+    return 1;
+}
+
+int HypamasLevelILUSaveAnalysis(
+    IN__ void *ilu,
+    IN__ char *file,
+    IN__ int *ap,
+    IN__ int *ai)
+{
+    _HypamasLevelILU *p;
+    _HypamasAnalysisHeader head;
+    const int *arrays[_ANALYSIS_ARRAYS];
+    long long count[_ANALYSIS_ARRAYS], offset, pad;
+    FILE *fp;
+    int i, retval;
+    static const char zero[8] = {0};
+
+    if (NULL == ilu || NULL == file || NULL == ap || NULL == ai)
+        return kErrorInvalidArgument;
+
+    p = (_HypamasLevelILU *)ilu;
+    if (NULL == p->bp)
+        return kErrorPhaseNotAnalyzed;
+    if (p->nnz != ap[p->n] - ap[0])
+        return kErrorMatrixConsistencyCheck;
+
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, _ANALYSIS_MAGIC, sizeof(_ANALYSIS_MAGIC));
+    head.version = _ANALYSIS_VERSION;
+    head.header = sizeof(head);
+    head.n = p->n;
+    head.nnz = p->nnz;
+    head.lunnz = p->bp[p->n];
+    head.fill = p->fill;
+    head.mode = p->mode;
+    head.lnum = p->lnum;
+    head.unum = p->unum;
+    head.checksum = _HypamasPatternChecksum(p->n, ap, ai);
+
+    arrays[0] = p->perm;
+    arrays[1] = p->map;
+    arrays[2] = p->bp;
+    arrays[3] = p->bi;
+    arrays[4] = p->diag;
+    arrays[5] = p->lptr;
+    arrays[6] = p->lrows;
+    arrays[7] = p->uptr;
+    arrays[8] = p->urows;
+    _AnalysisArrays(&head, count);
+    offset = sizeof(head);
+    for (i = 0; i < _ANALYSIS_ARRAYS; ++i)
+    {
+        head.offset[i] = offset;
+        offset += (count[i] * (long long)sizeof(int) + 7) / 8 * 8;
+    }
+
+    fp = fopen(file, "wb");
+    if (NULL == fp)
+        return kErrorOpenFileFail;
+
+    retval = kHypamasOK;
+    if (1 != fwrite(&head, sizeof(head), 1, fp))
+        retval = kErrorOpenFileFail;
+    for (i = 0; i < _ANALYSIS_ARRAYS && kHypamasOK == retval; ++i)
+    {
+        pad = (count[i] * (long long)sizeof(int) + 7) / 8 * 8 - count[i] * (long long)sizeof(int);
+        if ((size_t)count[i] != fwrite(arrays[i], sizeof(int), count[i], fp) ||
+            (size_t)pad != fwrite(zero, 1, pad, fp))
+            retval = kErrorOpenFileFail;
+    }
+    if (0 != fclose(fp))
+        retval = kErrorOpenFileFail;
+
+    return retval;
+}
+
+int HypamasLevelILULoadAnalysis(
+    INOUT__ void *ilu,
+    IN__ char *file,
+    IN__ int n,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ int mode)
+{
+    _HypamasLevelILU *p;
+    _HypamasAnalysisHeader *head;
+    int **arrays[_ANALYSIS_ARRAYS];
+    long long count[_ANALYSIS_ARRAYS];
+    struct stat st;
+    void *base;
+    int fd, i, retval;
+
+    if (NULL == ilu || NULL == file || NULL == ap || NULL == ai || n <= 0)
+        return kErrorInvalidArgument;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return kErrorOpenFileFail;
+    if (0 != fstat(fd, &st) || st.st_size < (off_t)sizeof(_HypamasAnalysisHeader))
+    {
+        close(fd);
+        return kErrorOpenFileFail;
+    }
+    base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == base)
+        return kErrorOpenFileFail;
+
+    head = (_HypamasAnalysisHeader *)base;
+    if (0 != memcmp(head->magic, _ANALYSIS_MAGIC, sizeof(_ANALYSIS_MAGIC)) ||
+        _ANALYSIS_VERSION != head->version || sizeof(_HypamasAnalysisHeader) != head->header)
+    {
+        retval = kErrorOpenFileFail;
+        goto FINAL;
+    }
+    if (n != head->n || ap[n] - ap[0] != head->nnz || (0 != mode) != head->mode ||
+        _HypamasPatternChecksum(n, ap, ai) != head->checksum)
+    {
+        retval = kErrorMatrixConsistencyCheck;
+        goto FINAL;
+    }
+    if (head->lunnz < 0 || head->lnum < 0 || head->lnum > n || head->unum < 0 || head->unum > n)
+    {
+        retval = kErrorOpenFileFail;
+        goto FINAL;
+    }
+    _AnalysisArrays(head, count);
+    for (i = 0; i < _ANALYSIS_ARRAYS; ++i)
+    {
+        if (head->offset[i] < (long long)sizeof(_HypamasAnalysisHeader) || 0 != head->offset[i] % sizeof(int) ||
+            head->offset[i] + count[i] * (long long)sizeof(int) > (long long)st.st_size)
+        {
+            retval = kErrorOpenFileFail;
+            goto FINAL;
+        }
+    }
+    if (!_AnalysisValid(head, (const char *)base))
+    {
+        retval = kErrorOpenFileFail;
+        goto FINAL;
+    }
+
+    p = (_HypamasLevelILU *)ilu;
+    _HypamasLevelILUFree(p);
+    p->n = head->n;
+    p->nnz = head->nnz;
+    p->fill = head->fill;
+    p->mode = head->mode;
+    p->lnum = head->lnum;
+    p->unum = head->unum;
+    arrays[0] = &p->perm;
+    arrays[1] = &p->map;
+    arrays[2] = &p->bp;
+    arrays[3] = &p->bi;
+    arrays[4] = &p->diag;
+    arrays[5] = &p->lptr;
+    arrays[6] = &p->lrows;
+    arrays[7] = &p->uptr;
+    arrays[8] = &p->urows;
+    for (i = 0; i < _ANALYSIS_ARRAYS; ++i)
+        *arrays[i] = (int *)((char *)base + head->offset[i]);
+    p->mapped = base;
+    p->mapped_size = st.st_size;
+    base = NULL;
+
+    retval = _HypamasLevelILUAllocNumeric(p);
+    if (FAIL(retval))
+        _HypamasLevelILUFree(p);
+
+FINAL:
+
+    if (NULL != base)
+        munmap(base, st.st_size);
+
+    return retval;
+}
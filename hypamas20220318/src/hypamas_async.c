@@ -0,0 +1,424 @@
+/*used to run the factorization & solving of handlers in the background of the caller*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "hypamas_ext_internal.h"
+
+#define _ASYNC_FACTORIZE 1   /* HypamasFactorize */
+#define _ASYNC_REFACTORIZE 2 /* HypamasReFactorize */
+#define _ASYNC_SOLVE 4       /* HypamasSolve */
+#define _ASYNC_RESIDUAL 8    /* HypamasResidualNorm of the solution */
+
+/**
+ * @brief Two value arrays of the same pattern, one stamped by the caller while the other is factorized
+ */
+typedef struct
+{
+    double *ax[2];
+    int next;    /* slot returned by the next HypamasValueBufferNext */
+    int current; /* slot last returned, -1 before the first */
+    int busy[2]; /* requests not done with the factorization of each slot */
+} _AsyncValues;
+
+/**
+ * @brief A submission, its stages run one after another by the async worker without returning to the caller
+ */
+typedef struct _AsyncRequest
+{
+    struct _AsyncRequest *next; /* in the queue or in the free list */
+    void *handler;
+    int stages;
+    double *ax;
+    _AsyncValues *values; /* ax is taken from its slot if not NULL */
+    int slot;
+    int *ap;
+    int *ai;
+    double *rhs;
+    double *sol;
+    double *residual;
+    int threads;
+    int status;
+    int done;
+} _AsyncRequest;
+
+static pthread_mutex_t g_async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_async_work = PTHREAD_COND_INITIALIZER; /* the worker waits for the queue */
+static pthread_cond_t g_async_done = PTHREAD_COND_INITIALIZER; /* the callers wait for requests & value slots */
+static _AsyncRequest *g_async_head = NULL;
+static _AsyncRequest *g_async_tail = NULL;
+static _AsyncRequest *g_async_free = NULL; /* finished requests kept for the next submissions */
+static int g_async_started = 0;
+
+static int _AsyncStages(_AsyncRequest *r)
+{
+    double *ax, rerr;
+    int retval, status;
+
+    ax = NULL != r->values ? r->values->ax[r->slot] : r->ax;
+    status = kHypamasOK;
+
+    if (r->stages & (_ASYNC_FACTORIZE | _ASYNC_REFACTORIZE))
+    {
+        if (r->stages & _ASYNC_FACTORIZE)
+            retval = HypamasFactorize(r->handler, ax, r->threads);
+        else
+            retval = HypamasReFactorize(r->handler, ax, r->threads);
+
+        /*the caller may stamp into the slot again once the factors are built*/
+        if (NULL != r->values && 0 == (r->stages & _ASYNC_RESIDUAL))
+        {
+            pthread_mutex_lock(&g_async_lock);
+            --r->values->busy[r->slot];
+            pthread_cond_broadcast(&g_async_done);
+            pthread_mutex_unlock(&g_async_lock);
+        }
+        if (FAIL(retval))
+            return retval;
+        if (WARNING(retval))
+            status = retval;
+    }
+
+    if (r->stages & _ASYNC_SOLVE)
+    {
+        retval = HypamasSolve(r->handler, r->rhs, r->sol, r->threads);
+        if (FAIL(retval))
+            return retval;
+        if (WARNING(retval))
+            status = retval;
+    }
+
+    if (r->stages & _ASYNC_RESIDUAL)
+    {
+        retval = HypamasResidualNorm(r->handler, ax, r->ap, r->ai, r->sol, r->rhs, NULL, &rerr, NULL);
+        if (FAIL(retval))
+            return retval;
+        *r->residual = rerr;
+    }
+
+    return status;
+}
+
+static void *_AsyncThreadProc(void *arg)
+{
+    _AsyncRequest *r;
+    int status;
+    long long start;
+    (void)arg;
+
+    pthread_mutex_lock(&g_async_lock);
+    while (1)
+    {
+        while (NULL == g_async_head)
+            pthread_cond_wait(&g_async_work, &g_async_lock);
+        r = g_async_head;
+        g_async_head = r->next;
+        if (NULL == g_async_head)
+            g_async_tail = NULL;
+        pthread_mutex_unlock(&g_async_lock);
+
+        start = _HypamasTraceClock();
+        status = _AsyncStages(r);
+        _HypamasTraceRecord(kTracePhaseAsync, start, 0.);
+
+        pthread_mutex_lock(&g_async_lock);
+        /*the slot of a chain with a residual is read until the end*/
+        if (NULL != r->values && (r->stages & _ASYNC_RESIDUAL))
+            --r->values->busy[r->slot];
+        r->status = status;
+        __atomic_store_n(&r->done, 1, __ATOMIC_RELEASE);
+        pthread_cond_broadcast(&g_async_done);
+    }
+
+    return NULL;
+}
+
+/*Queue a request filled by the caller, the worker is started by the first one.*/
+static int _AsyncSubmit(const _AsyncRequest *desc, void **request)
+{
+    _AsyncRequest *r;
+    pthread_t thread;
+
+    if (NULL == request)
+        return kErrorInvalidArgument;
+    *request = NULL;
+    if (NULL == desc->handler)
+        return kErrorInvalidArgument;
+    if (!_HYPAMAS_INITIALIZED(_HYPAMAS_HANDLER(desc->handler)))
+        return kErrorPhaseNotInitialized;
+    if (!_HYPAMAS_ANALYZED(_HYPAMAS_HANDLER(desc->handler)))
+        return kErrorPhaseNotAnalyzed;
+
+    pthread_mutex_lock(&g_async_lock);
+    if (!g_async_started)
+    {
+        if (0 != pthread_create(&thread, NULL, _AsyncThreadProc, NULL))
+        {
+            pthread_mutex_unlock(&g_async_lock);
+            return kErrorThreadInitializeFail;
+        }
+        pthread_detach(thread);
+        g_async_started = 1;
+    }
+    if (NULL != desc->values && desc->values->current < 0)
+    {
+        pthread_mutex_unlock(&g_async_lock);
+        return kErrorInvalidArgument;
+    }
+
+    r = g_async_free;
+    if (NULL != r)
+    {
+        g_async_free = r->next;
+    }
+    else
+    {
+        r = (_AsyncRequest *)_HypamasMalloc(sizeof(_AsyncRequest));
+        if (NULL == r)
+        {
+            pthread_mutex_unlock(&g_async_lock);
+            return kErrorOutOfMemory;
+        }
+    }
+    *r = *desc;
+    r->next = NULL;
+    r->status = kHypamasOK;
+    r->done = 0;
+    if (NULL != r->values)
+    {
+        r->slot = r->values->current;
+        ++r->values->busy[r->slot];
+    }
+
+    if (NULL == g_async_tail)
+        g_async_head = r;
+    else
+        g_async_tail->next = r;
+    g_async_tail = r;
+    pthread_cond_signal(&g_async_work);
+    pthread_mutex_unlock(&g_async_lock);
+
+    *request = r;
+    return kHypamasOK;
+}
+
+static void _AsyncDesc(_AsyncRequest *desc, void *handler, int stages, double *ax, void *values, int threads)
+{
+    desc->handler = handler;
+    desc->stages = stages;
+    desc->ax = ax;
+    desc->values = (_AsyncValues *)values;
+    desc->slot = 0;
+    desc->ap = NULL;
+    desc->ai = NULL;
+    desc->rhs = NULL;
+    desc->sol = NULL;
+    desc->residual = NULL;
+    desc->threads = threads;
+}
+
+int HypamasFactorizeAsync(
+    INOUT__ void *handler,
+    IN__ double *ax,
+    IN__ void *values,
+    IN__ int threads,
+    OUT__ void **request)
+{
+    _AsyncRequest desc;
+
+    if (NULL == ax && NULL == values)
+        return kErrorInvalidArgument;
+    _AsyncDesc(&desc, handler, _ASYNC_FACTORIZE, ax, values, threads);
+    return _AsyncSubmit(&desc, request);
+}
+
+int HypamasReFactorizeAsync(
+    INOUT__ void *handler,
+    IN__ double *ax,
+    IN__ void *values,
+    IN__ int threads,
+    OUT__ void **request)
+{
+    _AsyncRequest desc;
+
+    if (NULL == ax && NULL == values)
+        return kErrorInvalidArgument;
+    _AsyncDesc(&desc, handler, _ASYNC_REFACTORIZE, ax, values, threads);
+    return _AsyncSubmit(&desc, request);
+}
+
+int HypamasSolveAsync(
+    INOUT__ void *handler,
+    INOUT__ double *rhs,
+    OUT__ double *sol,
+    IN__ int threads,
+    OUT__ void **request)
+{
+    _AsyncRequest desc;
+
+    if (NULL == rhs)
+        return kErrorInvalidArgument;
+    _AsyncDesc(&desc, handler, _ASYNC_SOLVE, NULL, NULL, threads);
+    desc.rhs = rhs;
+    desc.sol = sol;
+    return _AsyncSubmit(&desc, request);
+}
+
+int HypamasReFactorizeSolveAsync(
+    INOUT__ void *handler,
+    IN__ double *ax,
+    IN__ void *values,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ double *rhs,
+    OUT__ double *sol,
+    OUT__ double *residual,
+    IN__ int threads,
+    OUT__ void **request)
+{
+    _AsyncRequest desc;
+    int stages;
+
+    if ((NULL == ax && NULL == values) || NULL == rhs)
+        return kErrorInvalidArgument;
+    stages = _ASYNC_REFACTORIZE | _ASYNC_SOLVE;
+    if (NULL != residual)
+    {
+        /*the residual needs the right hand side kept and the pattern*/
+        if (NULL == sol || NULL == ap || NULL == ai)
+            return kErrorInvalidArgument;
+        stages |= _ASYNC_RESIDUAL;
+    }
+    _AsyncDesc(&desc, handler, stages, ax, values, threads);
+    desc.ap = ap;
+    desc.ai = ai;
+    desc.rhs = rhs;
+    desc.sol = sol;
+    desc.residual = residual;
+    return _AsyncSubmit(&desc, request);
+}
+
+/*Return a finished request to the free list, the lock is held.*/
+static int _AsyncRetire(void **request)
+{
+    _AsyncRequest *r = (_AsyncRequest *)*request;
+    int status;
+
+    status = r->status;
+    r->next = g_async_free;
+    g_async_free = r;
+    *request = NULL;
+
+    return status;
+}
+
+int HypamasWait(
+    INOUT__ void **request)
+{
+    _AsyncRequest *r;
+    int status;
+
+    if (NULL == request || NULL == *request)
+        return kErrorInvalidArgument;
+    r = (_AsyncRequest *)*request;
+
+    pthread_mutex_lock(&g_async_lock);
+    while (!r->done)
+        pthread_cond_wait(&g_async_done, &g_async_lock);
+    status = _AsyncRetire(request);
+    pthread_mutex_unlock(&g_async_lock);
+
+    return status;
+}
+
+int HypamasTest(
+    INOUT__ void **request,
+    OUT__ int *done)
+{
+    _AsyncRequest *r;
+    int status;
+
+    if (NULL == request || NULL == *request || NULL == done)
+        return kErrorInvalidArgument;
+    r = (_AsyncRequest *)*request;
+
+    *done = __atomic_load_n(&r->done, __ATOMIC_ACQUIRE);
+    if (!*done)
+        return kHypamasOK;
+
+    pthread_mutex_lock(&g_async_lock);
+    status = _AsyncRetire(request);
+    pthread_mutex_unlock(&g_async_lock);
+
+    return status;
+}
+
+int HypamasValueBufferCreate(
+    OUT__ void **values,
+    IN__ int nnz)
+{
+    _AsyncValues *v;
+
+    if (NULL == values || nnz < 0)
+        return kErrorInvalidArgument;
+    *values = NULL;
+
+    v = (_AsyncValues *)_HypamasCalloc(1, sizeof(_AsyncValues));
+    if (NULL == v)
+        return kErrorOutOfMemory;
+    v->ax[0] = (double *)_HypamasMalloc(sizeof(double) * _HYPAMAS_MAX(1, nnz));
+    v->ax[1] = (double *)_HypamasMalloc(sizeof(double) * _HYPAMAS_MAX(1, nnz));
+    if (NULL == v->ax[0] || NULL == v->ax[1])
+    {
+        _HypamasFree(v->ax[0]);
+        _HypamasFree(v->ax[1]);
+        _HypamasFree(v);
+        return kErrorOutOfMemory;
+    }
+    v->current = -1;
+
+    *values = v;
+    return kHypamasOK;
+}
+
+int HypamasValueBufferNext(
+    INOUT__ void *values,
+    OUT__ double **ax)
+{
+    _AsyncValues *v = (_AsyncValues *)values;
+
+    if (NULL == v || NULL == ax)
+        return kErrorInvalidArgument;
+
+    pthread_mutex_lock(&g_async_lock);
+    while (0 != v->busy[v->next])
+        pthread_cond_wait(&g_async_done, &g_async_lock);
+    v->current = v->next;
+    v->next = 1 - v->next;
+    *ax = v->ax[v->current];
+    pthread_mutex_unlock(&g_async_lock);
+
+    return kHypamasOK;
+}
+
+int HypamasValueBufferFree(
+    INOUT__ void *values)
+{
+    _AsyncValues *v = (_AsyncValues *)values;
+
+    if (NULL == v)
+        return kErrorInvalidArgument;
+
+    /*requests still reading the arrays are waited for*/
+    pthread_mutex_lock(&g_async_lock);
+    while (0 != v->busy[0] || 0 != v->busy[1])
+        pthread_cond_wait(&g_async_done, &g_async_lock);
+    pthread_mutex_unlock(&g_async_lock);
+
+    _HypamasFree(v->ax[0]);
+    _HypamasFree(v->ax[1]);
+    _HypamasFree(v);
+
+    return kHypamasOK;
+}
@@ -0,0 +1,169 @@
+/*used to refactorize and solve many handlers of the same pattern together*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include "hypamas_ext_internal.h"
+
+typedef struct
+{
+    void **handlers;
+    int count;
+    double **ax; /* HypamasReFactorize if not NULL, otherwise HypamasSolve */
+    double **rhs;
+    double **sol;
+    int inner;   /* threads of each handler */
+    int next;    /* next handler to be taken */
+    int *status; /* count */
+} _BatchArgs;
+
+/*Each member takes the next handler until all are done, so a slow one does not hold the others.*/
+static void _BatchProc(void *arg, int tid, int threads)
+{
+    _BatchArgs *args = (_BatchArgs *)arg;
+    int i;
+    (void)tid;
+    (void)threads;
+
+    while ((i = __atomic_fetch_add(&args->next, 1, __ATOMIC_RELAXED)) < args->count)
+    {
+        if (NULL != args->ax)
+            args->status[i] = HypamasReFactorize(args->handlers[i], args->ax[i], args->inner);
+        else
+            args->status[i] = HypamasSolve(args->handlers[i], args->rhs[i], NULL == args->sol ? NULL : args->sol[i], args->inner);
+    }
+}
+
+static int _BatchCheck(void **handlers, int count)
+{
+    _HypamasHandler *h;
+    int i;
+
+    for (i = 0; i < count; ++i)
+    {
+        if (NULL == handlers[i])
+            return kErrorInvalidArgument;
+        h = _HYPAMAS_HANDLER(handlers[i]);
+        if (!_HYPAMAS_INITIALIZED(h))
+            return kErrorPhaseNotInitialized;
+        if (!_HYPAMAS_ANALYZED(h))
+            return kErrorPhaseNotAnalyzed;
+        if (!_HYPAMAS_FACTORIZED(h))
+            return kErrorPhaseNotFactorized;
+        if (h->n != _HYPAMAS_HANDLER(handlers[0])->n)
+            return kErrorMatrixConsistencyCheck;
+    }
+
+    return kHypamasOK;
+}
+
+static int _BatchRun(_BatchArgs *args, int threads, int *status)
+{
+    _HypamasTeam *team;
+    int retval, i, outer;
+    long long start;
+    size_t mark;
+
+    if (threads <= 0)
+        threads = _HYPAMAS_HANDLER(args->handlers[0])->iparm[kIparmThreadCreated];
+    threads = _HYPAMAS_MAX(1, threads);
+    outer = _HYPAMAS_MIN(threads, args->count);
+    args->inner = _HYPAMAS_MAX(1, threads / args->count);
+    args->next = 0;
+
+    start = _HypamasTraceClock();
+    mark = _HypamasArenaMark();
+    args->status = NULL != status ? status : (int *)_HypamasArenaAlloc(sizeof(int) * args->count);
+    if (NULL == args->status)
+        return kErrorOutOfMemory;
+
+    retval = _HypamasTeamAcquire(&team, outer);
+    if (FAIL(retval))
+        goto FINAL;
+    _HypamasTeamRun(team, outer, _BatchProc, args);
+    _HypamasTeamRelease(team);
+
+    retval = kHypamasOK;
+    for (i = 0; i < args->count; ++i)
+    {
+        if (FAIL(args->status[i]))
+        {
+            retval = args->status[i];
+            break;
+        }
+        if (WARNING(args->status[i]))
+            retval = args->status[i];
+    }
+
+FINAL:
+
+    _HypamasArenaReset(mark);
+    _HypamasTraceRecord(kTracePhaseBatch, start, 0.);
+
+    return retval;
+}
+
+int HypamasBatchReFactorize(
+    INOUT__ void **handlers,
+    IN__ int count,
+    IN__ double **ax,
+    IN__ int threads,
+    OUT__ int *status)
+{
+    _BatchArgs args;
+    int retval, i;
+
+    if (NULL == handlers || NULL == ax || count < 0)
+        return kErrorInvalidArgument;
+    if (0 == count)
+        return kHypamasOK;
+    for (i = 0; i < count; ++i)
+    {
+        if (NULL == ax[i])
+            return kErrorInvalidArgument;
+    }
+    retval = _BatchCheck(handlers, count);
+    if (FAIL(retval))
+        return retval;
+
+    args.handlers = handlers;
+    args.count = count;
+    args.ax = ax;
+    args.rhs = NULL;
+    args.sol = NULL;
+
+    return _BatchRun(&args, threads, status);
+}
+
+int HypamasBatchSolve(
+    INOUT__ void **handlers,
+    IN__ int count,
+    INOUT__ double **rhs,
+    OUT__ double **sol,
+    IN__ int threads,
+    OUT__ int *status)
+{
+    _BatchArgs args;
+    int retval, i;
+
+    if (NULL == handlers || NULL == rhs || count < 0)
+        return kErrorInvalidArgument;
+    if (0 == count)
+        return kHypamasOK;
+    for (i = 0; i < count; ++i)
+    {
+        if (NULL == rhs[i])
+            return kErrorInvalidArgument;
+    }
+    retval = _BatchCheck(handlers, count);
+    if (FAIL(retval))
+        return retval;
+
+    args.handlers = handlers;
+    args.count = count;
+    args.ax = NULL;
+    args.rhs = rhs;
+    args.sol = sol;
+
+    return _BatchRun(&args, threads, status);
+}
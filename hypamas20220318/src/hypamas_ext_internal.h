@@ -0,0 +1,393 @@
+/*used to define internal structure and routine shared by the extension*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#ifndef __HYPAMAS_EXT_INTERNAL__
+#define __HYPAMAS_EXT_INTERNAL__
+
+#include <time.h>
+#include <stddef.h>
+#include "hypamas_ext.h"
+
+/**
+ * @brief Leading members of the handler created by HypamasInit.
+ * The extension only reads these members, the layout follows libhypamas 20220318.
+ */
+typedef struct
+{
+    char *status;   /* status[0]: initialized, status[1]: analyzed */
+    int *iparm;     /* the same array returned by HypamasInit */
+    double *dparm;  /* the same array returned by HypamasInit */
+    int n;          /* dimension of the matrix, valid after HypamasAnalyze */
+    int factorized; /* non-zero after (in)factorization */
+} _HypamasHandler;
+
+#define _HYPAMAS_HANDLER(handler) ((_HypamasHandler *)(handler))
+#define _HYPAMAS_INITIALIZED(h) (0 != (h)->status[0])
+#define _HYPAMAS_ANALYZED(h) (0 != (h)->status[1])
+#define _HYPAMAS_FACTORIZED(h) (0 != (h)->factorized)
+
+#define _HYPAMAS_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define _HYPAMAS_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/*Wall clock in seconds.*/
+static inline double _HypamasWallTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+/*64-bit FNV-1a checksum of the pattern of a CSR or CSC matrix.*/
+unsigned long long _HypamasPatternChecksum(
+    IN__ int n,
+    IN__ const int *ap,
+    IN__ const int *ai);
+
+/*Allocation through the hooks of Hypamas_SetAllocator, memory of the extension must be released by _HypamasFree.*/
+void *_HypamasMalloc(
+    IN__ size_t size);
+
+void *_HypamasCalloc(
+    IN__ size_t count,
+    IN__ size_t size);
+
+void *_HypamasRealloc(
+    IN__ void *ptr,
+    IN__ size_t size);
+
+void _HypamasFree(
+    IN__ void *ptr);
+
+/*Scratch of the calling thread aligned to a cache line, valid until _HypamasArenaReset to a mark taken before it.*/
+void *_HypamasArenaAlloc(
+    IN__ size_t size);
+
+size_t _HypamasArenaMark(void);
+
+void _HypamasArenaReset(
+    IN__ size_t mark);
+
+/*Thread team shared by the parallel regions of the extension, threads including the calling thread.*/
+typedef struct _HypamasTeam _HypamasTeam;
+typedef void (*_HypamasTaskProc)(void *arg, int tid, int threads);
+
+/*Lock the process-wide team with at least threads members, created on demand.*/
+int _HypamasTeamAcquire(
+    OUT__ _HypamasTeam **team,
+    IN__ int threads);
+
+void _HypamasTeamRelease(
+    IN__ _HypamasTeam *team);
+
+/*Run proc on threads members of the team, the calling thread works as tid 0.*/
+void _HypamasTeamRun(
+    IN__ _HypamasTeam *team,
+    IN__ int threads,
+    IN__ _HypamasTaskProc proc,
+    IN__ void *arg);
+
+void _HypamasTeamBarrier(
+    IN__ _HypamasTeam *team,
+    IN__ int threads);
+
+/*Dependency graph executed by work stealing inside a region of the team.*/
+typedef struct _HypamasTaskGraph _HypamasTaskGraph;
+typedef void (*_HypamasNodeProc)(void *arg, int node, int tid);
+
+/*Graph of n nodes for up to threads threads, sp/si/indeg are referenced and must outlive the graph.*/
+int _HypamasTaskGraphCreate(
+    OUT__ _HypamasTaskGraph **graph,
+    IN__ int n,
+    IN__ const int *sp,
+    IN__ const int *si,
+    IN__ const int *indeg,
+    IN__ int threads);
+
+void _HypamasTaskGraphFree(
+    IN__ _HypamasTaskGraph *graph);
+
+int _HypamasTaskGraphThreads(
+    IN__ const _HypamasTaskGraph *graph);
+
+/*Number of nodes stolen from other threads in the last run.*/
+int _HypamasTaskGraphSteals(
+    IN__ const _HypamasTaskGraph *graph);
+
+/*Run proc on every node after all its predecessors, called by all threads of a region.*/
+/*Each thread keeps a deque of ready nodes and steals the oldest node of another thread when its own is empty.*/
+void _HypamasTaskGraphRun(
+    INOUT__ _HypamasTaskGraph *graph,
+    IN__ _HypamasTeam *team,
+    IN__ int tid,
+    IN__ int threads,
+    IN__ _HypamasNodeProc proc,
+    IN__ void *arg);
+
+/*Total wake-up latency of the workers in nanoseconds and number of wake-ups since the start, see Hypamas_ThreadPoolWakeLatency.*/
+void _HypamasTeamWakeCounters(
+    OUT__ long long *total,
+    OUT__ long long *count);
+
+/*Trace clock in nanoseconds to pass to _HypamasTraceRecord, 0 while the trace is stopped so that the record is skipped.*/
+long long _HypamasTraceClock(void);
+
+/*Record an interval of phase(HypamasTracePhase) from start to now on the calling thread.*/
+void _HypamasTraceRecord(
+    IN__ int phase,
+    IN__ long long start,
+    IN__ double flops);
+
+/*Add tasks run by the calling thread.*/
+void _HypamasTraceTasks(
+    IN__ long long tasks);
+
+/*Split rows into parts balancing nnz + weight*rows, part has parts+1 entries.*/
+void _HypamasPartitionRows(
+    IN__ int n,
+    IN__ const int *ap,
+    IN__ int weight,
+    IN__ int parts,
+    OUT__ int *part);
+
+/*B = A' of the rows [ab[i], ae[i]) of an n x n pattern, bp has n+1 entries. ax & bx, and bmap(position in ai) may be NULL.*/
+/*Run on threads, the columns of B are in ascending rows and the result does not depend on threads.*/
+int _HypamasTranspose(
+    IN__ int n,
+    IN__ const int *ab,
+    IN__ const int *ae,
+    IN__ const int *ai,
+    IN__ const double *ax,
+    OUT__ int *bp,
+    OUT__ int *bi,
+    OUT__ double *bx,
+    OUT__ int *bmap,
+    IN__ int threads);
+
+/*Preconditioner applied collectively by all threads of a region: out = inv(M)*in.*/
+/*On entry in is complete, on exit out is complete on all threads, a non-OK return value is the same on all threads.*/
+typedef int (*_HypamasPrecondProc)(void *data, const double *in, double *out, _HypamasTeam *team, int tid, int threads);
+
+/**
+ * @brief Shared state of the parallel GMRES
+ */
+typedef struct
+{
+    int n;
+    const double *ax; /* values of the caller, CSR or CSC */
+    const int *ap;    /* CSR pattern of the operator */
+    const int *ai;
+    const int *map; /* entry p of the CSR pattern is ax[map[p]], NULL if ax is CSR */
+    const double *rhs;
+    double *sol;
+
+    _HypamasPrecondProc precond; /* NULL means no preconditioner */
+    void *precond_data;
+
+    int restart;    /* Krylov subspace dimension */
+    int maxiter;    /* maximum iteration number */
+    int stagnation; /* maximum number of stagnation step */
+    int orth;       /* HypamasCfgGMRESOrth, not auto */
+    double tol;     /* relative tolerance to |b| */
+
+    int *part;      /* row partition, threads+1 entries */
+    double *v;      /* Krylov basis, (restart+1)*n */
+    double *z;      /* preconditioned vector, n */
+    double *w;      /* new Krylov vector, n */
+    double *reduce; /* partial sums, 2*threads*stride */
+    int stride;
+    double *local; /* thread private Hessenberg & rotations, threads*lstride */
+    int lstride;
+    _HypamasTeam *team;
+
+    int iter;   /* [OUT] number of iterations */
+    int retval; /* [OUT] status */
+} _HypamasGMRESContext;
+
+/*Size of the thread private storage of the GMRES in doubles.*/
+int _HypamasGMRESLocalSize(
+    IN__ int restart);
+
+/*Restarted GMRES with right preconditioning run on threads members of team.*/
+void _HypamasGMRESParallel(
+    INOUT__ _HypamasGMRESContext *ctx,
+    IN__ _HypamasTeam *team,
+    IN__ int threads);
+
+/**
+ * @brief CSR pattern of a CSC matrix with the position of each entry in the CSC values
+ */
+typedef struct
+{
+    const int *ap;
+    const int *ai;
+    const int *map;
+} _HypamasCSRView;
+
+/*Run the parallel GMRES of the handler with the given preconditioner, NULL means no preconditioner.*/
+/*With kIparmSolveTranspose ax, ap & ai are the CSC of A, view is their CSR view cached by the caller or NULL to build it in the scratch arena.*/
+int _HypamasGMRESRun(
+    INOUT__ void *handler,
+    IN__ double *ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ double *rhs,
+    INOUT__ double *sol,
+    IN__ int threads,
+    IN__ const _HypamasCSRView *view,
+    IN__ _HypamasPrecondProc precond,
+    IN__ void *precond_data);
+
+/**
+ * @brief ILU(k) of the row permuted matrix B = P*A with level sets of both factors
+ */
+typedef struct
+{
+    int n;
+    int nnz;
+    int fill;       /* level of fill */
+    int mode;       /* 0: input is CSR, otherwise CSC */
+    int factorized; /* non-zero after the numeric factorization */
+    int precision;  /* HypamasCfgILUPrecision of the factors */
+    int schedule;   /* HypamasCfgILUSchedule of the factorization */
+    int exact;      /* complete LU: fill raised to n by the analysis, a perturbed pivot fails the factorization */
+    int perturbed;  /* pivots perturbed by the running factorization */
+
+    int *perm; /* row k of B is row perm[k] of A */
+    int *map;  /* bx[q] comes from ax[map[q]], -1 for fill-in */
+    int *rp;   /* CSR view of a CSC input with the position in ax of each entry, kept for the GMRES, NULL for CSR */
+    int *ri;
+    int *rmap;
+    int *bp;   /* CSR of L\U, sorted columns, unit L */
+    int *bi;
+    double *bx;     /* NULL if the factors are in single precision */
+    float *bxs;     /* values of L\U in single precision, NULL if they are in double */
+    unsigned short *bd; /* |bi[q]-k| of row k read by the hot loops instead of bi, bd[diag[k]] holds _ILU_NEAR_* of row k */
+    int *diag;      /* position of the diagonal in each row */
+    double *rowmax; /* maximum absolute value of each row of B */
+    double flops;   /* operations of a factorization estimated from the pattern, 0 until traced */
+
+    int lnum; /* number of level sets of L */
+    int *lptr;
+    int *lrows;
+    int unum; /* number of level sets of U */
+    int *uptr;
+    int *urows;
+
+    int *lsp; /* CSC pattern of the strict L, the rows depending on each row, NULL until used */
+    int *lsi;
+    int *ldeg; /* number of rows each row depends on */
+    _HypamasTaskGraph *graph;
+
+    int *pos;     /* scatter position, n per thread of the factorization, -1 between rows */
+    int npos;     /* threads pos is allocated for */
+    double *work; /* n */
+
+    int batch;       /* instances of the batch factorization, 0 if none */
+    double *bxb;     /* values of L\U, entry q of instance b at q*batch+b */
+    double *rowmaxb; /* n*batch */
+    double *workb;   /* n*batch */
+
+    void *sparse; /* workspace & cached reach of the sparse solve, NULL until used */
+
+    void *mapped; /* analysis file holding perm to urows, NULL if they are allocated */
+    size_t mapped_size;
+} _HypamasLevelILU;
+
+void _HypamasLevelILUFree(
+    INOUT__ _HypamasLevelILU *ilu);
+
+/*Row permutation to a zero-free diagonal, pattern of the factors and level sets.*/
+/*The transpose of a CSC input, the assembly of the rows, the level of fill and the level sets run on threads, the result does not depend on threads.*/
+/*The matching stays sequential.*/
+int _HypamasLevelILUSymbolic(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int n,
+    IN__ const double *ax,
+    IN__ const int *ap,
+    IN__ const int *ai,
+    IN__ int mode,
+    IN__ int threads);
+
+int _HypamasLevelILUNumeric(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ const double *ax,
+    IN__ int threads);
+
+/*Refactorize only the rows of B holding the changed entries of ax and the rows depending on them through L.*/
+int _HypamasLevelILUPartialNumeric(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ const double *ax,
+    IN__ const int *changed,
+    IN__ int nchanged,
+    IN__ int threads,
+    OUT__ int *updated);
+
+/*Build lsp, lsi & ldeg if not yet.*/
+int _HypamasLevelILUGraph(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int threads);
+
+/*Operations of one factorization, computed at the first call after the analysis.*/
+double _HypamasLevelILUFlops(
+    INOUT__ _HypamasLevelILU *ilu);
+
+/*Non-zero if the level sets are wide enough to be scheduled over threads.*/
+int _HypamasLevelILUWide(
+    IN__ const _HypamasLevelILU *ilu,
+    IN__ int threads);
+
+/*Grow pos to threads threads, the entries are -1 on return.*/
+int _HypamasLevelILUPos(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int threads);
+
+/*Value q of L\U in either precision.*/
+static inline double _HypamasLevelILUValue(const _HypamasLevelILU *ilu, int q)
+{
+    return NULL != ilu->bxs ? (double)ilu->bxs[q] : ilu->bx[q];
+}
+
+/*Allocate the numeric arrays after the symbolic ones are set, the values in the precision of ilu.*/
+int _HypamasLevelILUAllocNumeric(
+    INOUT__ _HypamasLevelILU *ilu);
+
+/*ILU of count matrices with the pattern of the analysis, values interleaved by instance.*/
+int _HypamasLevelILUBatchNumeric(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int count,
+    IN__ double **ax,
+    IN__ int threads);
+
+/*out[b] = inv(U_b)*inv(L_b)*P*in[b] for all instances of the batch factorization.*/
+int _HypamasLevelILUBatchSolve(
+    IN__ _HypamasLevelILU *ilu,
+    IN__ double **in,
+    OUT__ double **out,
+    IN__ int threads);
+
+/*Entries out of inv(U)*inv(L)*P*b for a sparse b, only the reach of b through L and of out through U is visited.*/
+/*reach returns the sizes of both reach sets if not NULL.*/
+int _HypamasLevelILUSparseSolve(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int nz,
+    IN__ const int *idx,
+    IN__ const double *val,
+    IN__ int nout,
+    IN__ const int *out,
+    OUT__ double *sol,
+    OUT__ int *reach);
+
+void _HypamasLevelILUSparseFree(
+    INOUT__ void *sparse);
+
+/*out = inv(U)*inv(L)*P*in, a _HypamasPrecondProc.*/
+int _HypamasLevelILUApply(
+    IN__ void *data,
+    IN__ const double *in,
+    OUT__ double *out,
+    IN__ _HypamasTeam *team,
+    IN__ int tid,
+    IN__ int threads);
+
+#endif
@@ -0,0 +1,477 @@
+/*used to define dense BLAS-3 kernels: packed cache-blocked dgemm and blocked dtrsm*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include "hypamas_ext_internal.h"
+
+/*cache blocking: KC*NR doubles of B stay in L1, MC*KC doubles of A stay in L2, KC*NC doubles of B stay in L3*/
+#define _DGEMM_KC 256
+#define _DGEMM_MC 96
+#define _DGEMM_NC 4032
+#define _DGEMM_MR_MAX 16
+#define _DGEMM_NR_MAX 8
+#define _DGEMM_SMALL 4096 /* m*n*k below which packing does not pay off */
+#define _DTRSM_NB 16
+
+/*C(mr x nr) += alpha * packed A(mr x k) * packed B(k x nr), column-major C*/
+typedef void (*_HypamasMicroKernel)(int k, const double *pa, const double *pb, double alpha, double *c, int ldc);
+
+typedef struct
+{
+    const char *name;
+    int mr;
+    int nr;
+    _HypamasMicroKernel kernel;
+} _HypamasDgemmKernel;
+
+static void _Hypamas_dgemm_kernel_4x4(int k, const double *pa, const double *pb, double alpha, double *c, int ldc)
+{
+    double ab[16];
+    int p, i, j;
+
+    memset(ab, 0, sizeof(ab));
+    for (p = 0; p < k; ++p)
+    {
+        for (j = 0; j < 4; ++j)
+        {
+            for (i = 0; i < 4; ++i)
+                ab[j * 4 + i] += pa[i] * pb[j];
+        }
+        pa += 4;
+        pb += 4;
+    }
+    for (j = 0; j < 4; ++j)
+    {
+        for (i = 0; i < 4; ++i)
+            c[j * ldc + i] += alpha * ab[j * 4 + i];
+    }
+}
+
+#define _AVX2_COLUMN(j)                        \
+    b = _mm256_broadcast_sd(pb + (j));         \
+    c##j##0 = _mm256_fmadd_pd(a0, b, c##j##0); \
+    c##j##1 = _mm256_fmadd_pd(a1, b, c##j##1);
+
+#define _AVX2_STORE(j)                                                                          \
+    _mm256_storeu_pd(c + (j)*ldc, _mm256_fmadd_pd(alp, c##j##0, _mm256_loadu_pd(c + (j)*ldc))); \
+    _mm256_storeu_pd(c + (j)*ldc + 4, _mm256_fmadd_pd(alp, c##j##1, _mm256_loadu_pd(c + (j)*ldc + 4)));
+
+/*8x6 register tile: 12 accumulators, 2 columns of A and 1 broadcast of B in 16 ymm registers*/
+__attribute__((target("avx2,fma"))) static void _Hypamas_dgemm_kernel_avx2_8x6(int k, const double *pa, const double *pb, double alpha, double *c, int ldc)
+{
+    __m256d c00, c01, c10, c11, c20, c21, c30, c31, c40, c41, c50, c51;
+    __m256d a0, a1, b, alp;
+    int p;
+
+    c00 = c01 = c10 = c11 = c20 = c21 = _mm256_setzero_pd();
+    c30 = c31 = c40 = c41 = c50 = c51 = _mm256_setzero_pd();
+
+    for (p = 0; p < k; ++p)
+    {
+        a0 = _mm256_load_pd(pa);
+        a1 = _mm256_load_pd(pa + 4);
+        _AVX2_COLUMN(0)
+        _AVX2_COLUMN(1)
+        _AVX2_COLUMN(2)
+        _AVX2_COLUMN(3)
+        _AVX2_COLUMN(4)
+        _AVX2_COLUMN(5)
+        pa += 8;
+        pb += 6;
+    }
+
+    alp = _mm256_set1_pd(alpha);
+    _AVX2_STORE(0)
+    _AVX2_STORE(1)
+    _AVX2_STORE(2)
+    _AVX2_STORE(3)
+    _AVX2_STORE(4)
+    _AVX2_STORE(5)
+}
+
+#define _AVX512_COLUMN(j)                      \
+    b = _mm512_set1_pd(pb[j]);                 \
+    c##j##0 = _mm512_fmadd_pd(a0, b, c##j##0); \
+    c##j##1 = _mm512_fmadd_pd(a1, b, c##j##1);
+
+#define _AVX512_STORE(j)                                                                        \
+    _mm512_storeu_pd(c + (j)*ldc, _mm512_fmadd_pd(alp, c##j##0, _mm512_loadu_pd(c + (j)*ldc))); \
+    _mm512_storeu_pd(c + (j)*ldc + 8, _mm512_fmadd_pd(alp, c##j##1, _mm512_loadu_pd(c + (j)*ldc + 8)));
+
+/*16x8 register tile: 16 accumulators, 2 columns of A and 1 broadcast of B in 32 zmm registers*/
+__attribute__((target("avx512f"))) static void _Hypamas_dgemm_kernel_avx512_16x8(int k, const double *pa, const double *pb, double alpha, double *c, int ldc)
+{
+    __m512d c00, c01, c10, c11, c20, c21, c30, c31, c40, c41, c50, c51, c60, c61, c70, c71;
+    __m512d a0, a1, b, alp;
+    int p;
+
+    c00 = c01 = c10 = c11 = c20 = c21 = c30 = c31 = _mm512_setzero_pd();
+    c40 = c41 = c50 = c51 = c60 = c61 = c70 = c71 = _mm512_setzero_pd();
+
+    for (p = 0; p < k; ++p)
+    {
+        a0 = _mm512_load_pd(pa);
+        a1 = _mm512_load_pd(pa + 8);
+        _AVX512_COLUMN(0)
+        _AVX512_COLUMN(1)
+        _AVX512_COLUMN(2)
+        _AVX512_COLUMN(3)
+        _AVX512_COLUMN(4)
+        _AVX512_COLUMN(5)
+        _AVX512_COLUMN(6)
+        _AVX512_COLUMN(7)
+        pa += 16;
+        pb += 8;
+    }
+
+    alp = _mm512_set1_pd(alpha);
+    _AVX512_STORE(0)
+    _AVX512_STORE(1)
+    _AVX512_STORE(2)
+    _AVX512_STORE(3)
+    _AVX512_STORE(4)
+    _AVX512_STORE(5)
+    _AVX512_STORE(6)
+    _AVX512_STORE(7)
+}
+
+static const _HypamasDgemmKernel g_dgemm_kernels[] = {
+    {"auto", 0, 0, NULL},
+    {"generic_4x4", 4, 4, _Hypamas_dgemm_kernel_4x4},
+    {"avx2_8x6", 8, 6, _Hypamas_dgemm_kernel_avx2_8x6},
+    {"avx512_16x8", 16, 8, _Hypamas_dgemm_kernel_avx512_16x8},
+};
+
+static const _HypamasDgemmKernel *g_dgemm_kernel = NULL;
+static pthread_once_t g_dgemm_once = PTHREAD_ONCE_INIT;
+
+static int _HypamasDgemmKernelSupported(int kernel)
+{
+    __builtin_cpu_init();
+    switch (kernel)
+    {
+    case kDgemmKernelGeneric:
+        return 1;
+    case kDgemmKernelAVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case kDgemmKernelAVX512:
+        return __builtin_cpu_supports("avx512f");
+    default:
+        return 0;
+    }
+}
+
+static void _HypamasDgemmDetect(void)
+{
+    int kernel;
+
+    for (kernel = kDgemmKernelAVX512; kernel > kDgemmKernelGeneric; --kernel)
+    {
+        if (_HypamasDgemmKernelSupported(kernel))
+            break;
+    }
+    g_dgemm_kernel = &g_dgemm_kernels[kernel];
+}
+
+static const _HypamasDgemmKernel *_HypamasGetDgemmKernel(void)
+{
+    if (NULL == g_dgemm_kernel)
+        pthread_once(&g_dgemm_once, _HypamasDgemmDetect);
+    return g_dgemm_kernel;
+}
+
+int Hypamas_SelectDgemmKernel(
+    IN__ int kernel)
+{
+    if (kDgemmKernelAuto == kernel)
+    {
+        pthread_once(&g_dgemm_once, _HypamasDgemmDetect);
+        _HypamasDgemmDetect();
+        return kHypamasOK;
+    }
+    if (kernel < kDgemmKernelGeneric || kernel > kDgemmKernelAVX512)
+        return kErrorInvalidArgument;
+    if (!_HypamasDgemmKernelSupported(kernel))
+        return kErrorAlgorithmInvalid;
+
+    pthread_once(&g_dgemm_once, _HypamasDgemmDetect);
+    g_dgemm_kernel = &g_dgemm_kernels[kernel];
+    return kHypamasOK;
+}
+
+const char *Hypamas_DgemmKernelName(void)
+{
+    return _HypamasGetDgemmKernel()->name;
+}
+
+/*pack mc x kc block of A into slivers of mr rows, zero-padded*/
+static void _HypamasPackA(int mc, int kc, const double *a, int lda, int mr, double *pa)
+{
+    int i0, i, p, mb;
+
+    for (i0 = 0; i0 < mc; i0 += mr)
+    {
+        mb = _HYPAMAS_MIN(mr, mc - i0);
+        for (p = 0; p < kc; ++p)
+        {
+            const double *col = a + (size_t)p * lda + i0;
+            for (i = 0; i < mb; ++i)
+                pa[i] = col[i];
+            for (; i < mr; ++i)
+                pa[i] = 0.;
+            pa += mr;
+        }
+    }
+}
+
+/*pack kc x nc block of B into slivers of nr columns, zero-padded*/
+static void _HypamasPackB(int kc, int nc, const double *b, int ldb, int nr, double *pb)
+{
+    int j0, j, p, nb;
+
+    for (j0 = 0; j0 < nc; j0 += nr)
+    {
+        nb = _HYPAMAS_MIN(nr, nc - j0);
+        for (p = 0; p < kc; ++p)
+        {
+            for (j = 0; j < nb; ++j)
+                pb[j] = b[(size_t)(j0 + j) * ldb + p];
+            for (; j < nr; ++j)
+                pb[j] = 0.;
+            pb += nr;
+        }
+    }
+}
+
+static void _HypamasDgemmSmall(int m, int n, int k, double alpha, const double *a, int lda, const double *b, int ldb, double *c, int ldc)
+{
+    int i, j, p;
+    double t;
+
+    for (j = 0; j < n; ++j)
+    {
+        double *cj = c + (size_t)j * ldc;
+        for (p = 0; p < k; ++p)
+        {
+            const double *ap = a + (size_t)p * lda;
+            t = alpha * b[(size_t)j * ldb + p];
+            if (0. == t)
+                continue;
+            for (i = 0; i < m; ++i)
+                cj[i] += t * ap[i];
+        }
+    }
+}
+
+int Hypamas_dgemm(
+    IN__ int m,
+    IN__ int n,
+    IN__ int k,
+    IN__ double alpha,
+    IN__ double *a,
+    IN__ int lda,
+    IN__ double *b,
+    IN__ int ldb,
+    IN__ double beta,
+    INOUT__ double *c,
+    IN__ int ldc)
+{
+    const _HypamasDgemmKernel *kern;
+    double *pa, *pb, tile[_DGEMM_MR_MAX * _DGEMM_NR_MAX];
+    int i, j, jc, pc, ic, jr, ir, nc, kc, mc, nr, mr, mb, nb;
+    size_t mark;
+
+    if (m < 0 || n < 0 || k < 0 || ldc < _HYPAMAS_MAX(1, m))
+        return kErrorInvalidArgument;
+    if (k > 0 && (NULL == a || NULL == b || lda < _HYPAMAS_MAX(1, m) || ldb < _HYPAMAS_MAX(1, k)))
+        return kErrorInvalidArgument;
+    if (0 == m || 0 == n)
+        return kHypamasOK;
+    if (NULL == c)
+        return kErrorInvalidArgument;
+
+    if (1. != beta)
+    {
+        for (j = 0; j < n; ++j)
+        {
+            double *cj = c + (size_t)j * ldc;
+            if (0. == beta)
+                memset(cj, 0, sizeof(double) * m);
+            else
+            {
+                for (i = 0; i < m; ++i)
+                    cj[i] *= beta;
+            }
+        }
+    }
+    if (0 == k || 0. == alpha)
+        return kHypamasOK;
+
+    if ((long long)m * n * k <= _DGEMM_SMALL)
+    {
+        _HypamasDgemmSmall(m, n, k, alpha, a, lda, b, ldb, c, ldc);
+        return kHypamasOK;
+    }
+
+    kern = _HypamasGetDgemmKernel();
+    mr = kern->mr;
+    nr = kern->nr;
+
+    nc = _HYPAMAS_MIN(_DGEMM_NC, (n + nr - 1) / nr * nr);
+    /*the packed panels come from the scratch arena of the calling thread, aligned to a cache line*/
+    mark = _HypamasArenaMark();
+    pa = (double *)_HypamasArenaAlloc(sizeof(double) * _DGEMM_MC * _DGEMM_KC);
+    pb = (double *)_HypamasArenaAlloc(sizeof(double) * _DGEMM_KC * nc);
+    if (NULL == pa || NULL == pb)
+    {
+        _HypamasArenaReset(mark);
+        return kErrorOutOfMemory;
+    }
+
+    for (jc = 0; jc < n; jc += _DGEMM_NC)
+    {
+        nc = _HYPAMAS_MIN(_DGEMM_NC, n - jc);
+        for (pc = 0; pc < k; pc += _DGEMM_KC)
+        {
+            kc = _HYPAMAS_MIN(_DGEMM_KC, k - pc);
+            _HypamasPackB(kc, nc, b + (size_t)jc * ldb + pc, ldb, nr, pb);
+
+            for (ic = 0; ic < m; ic += _DGEMM_MC)
+            {
+                mc = _HYPAMAS_MIN(_DGEMM_MC, m - ic);
+                _HypamasPackA(mc, kc, a + (size_t)pc * lda + ic, lda, mr, pa);
+
+                for (jr = 0; jr < nc; jr += nr)
+                {
+                    nb = _HYPAMAS_MIN(nr, nc - jr);
+                    for (ir = 0; ir < mc; ir += mr)
+                    {
+                        double *cij = c + (size_t)(jc + jr) * ldc + ic + ir;
+                        const double *ppa = pa + (size_t)ir * kc;
+                        const double *ppb = pb + (size_t)jr * kc;
+
+                        mb = _HYPAMAS_MIN(mr, mc - ir);
+                        if (mb == mr && nb == nr)
+                        {
+                            kern->kernel(kc, ppa, ppb, alpha, cij, ldc);
+                            continue;
+                        }
+
+                        /*edge tile: compute the full register tile aside and add the valid part*/
+                        memset(tile, 0, sizeof(double) * mr * nr);
+                        kern->kernel(kc, ppa, ppb, alpha, tile, mr);
+                        for (j = 0; j < nb; ++j)
+                        {
+                            for (i = 0; i < mb; ++i)
+                                cij[(size_t)j * ldc + i] += tile[j * mr + i];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    _HypamasArenaReset(mark);
+    return kHypamasOK;
+}
+
+int Hypamas_dtrsm(
+    IN__ int uplo,
+    IN__ int diag,
+    IN__ int m,
+    IN__ int n,
+    IN__ double *a,
+    IN__ int lda,
+    INOUT__ double *b,
+    IN__ int ldb)
+{
+    int kb, ke, nb, i, r, j, retval;
+    double x;
+
+    if ((kUploLower != uplo && kUploUpper != uplo) || (kDiagNonUnit != diag && kDiagUnit != diag))
+        return kErrorInvalidArgument;
+    if (m < 0 || n < 0 || lda < _HYPAMAS_MAX(1, m) || ldb < _HYPAMAS_MAX(1, m))
+        return kErrorInvalidArgument;
+    if (0 == m || 0 == n)
+        return kHypamasOK;
+    if (NULL == a || NULL == b)
+        return kErrorInvalidArgument;
+
+    if (kDiagNonUnit == diag)
+    {
+        for (i = 0; i < m; ++i)
+        {
+            if (0. == a[(size_t)i * lda + i])
+                return kErrorMatrixNumericSingular;
+        }
+    }
+
+    if (kUploLower == uplo)
+    {
+        /*forward: solve the diagonal block, then update the rows below with dgemm*/
+        for (kb = 0; kb < m; kb += _DTRSM_NB)
+        {
+            nb = _HYPAMAS_MIN(_DTRSM_NB, m - kb);
+            ke = kb + nb;
+            for (j = 0; j < n; ++j)
+            {
+                double *bj = b + (size_t)j * ldb;
+                for (i = kb; i < ke; ++i)
+                {
+                    const double *ai = a + (size_t)i * lda;
+                    x = bj[i];
+                    if (kDiagNonUnit == diag)
+                        x /= ai[i];
+                    bj[i] = x;
+                    if (0. == x)
+                        continue;
+                    for (r = i + 1; r < ke; ++r)
+                        bj[r] -= ai[r] * x;
+                }
+            }
+            if (ke < m)
+            {
+                retval = Hypamas_dgemm(m - ke, n, nb, -1., a + (size_t)kb * lda + ke, lda, b + kb, ldb, 1., b + ke, ldb);
+                if (FAIL(retval))
+                    return retval;
+            }
+        }
+    }
+    else
+    {
+        /*backward: solve the diagonal block, then update the rows above with dgemm*/
+        for (ke = m; ke > 0; ke -= _DTRSM_NB)
+        {
+            kb = _HYPAMAS_MAX(0, ke - _DTRSM_NB);
+            nb = ke - kb;
+            for (j = 0; j < n; ++j)
+            {
+                double *bj = b + (size_t)j * ldb;
+                for (i = ke - 1; i >= kb; --i)
+                {
+                    const double *ai = a + (size_t)i * lda;
+                    x = bj[i];
+                    if (kDiagNonUnit == diag)
+                        x /= ai[i];
+                    bj[i] = x;
+                    if (0. == x)
+                        continue;
+                    for (r = kb; r < i; ++r)
+                        bj[r] -= ai[r] * x;
+                }
+            }
+            if (kb > 0)
+            {
+                retval = Hypamas_dgemm(kb, n, nb, -1., a + (size_t)kb * lda, lda, b + kb, ldb, 1., b, ldb);
+                if (FAIL(retval))
+                    return retval;
+            }
+        }
+    }
+
+    return kHypamasOK;
+}
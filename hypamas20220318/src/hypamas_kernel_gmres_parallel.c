@@ -0,0 +1,396 @@
+/*used to define the parallel restarted GMRES with right preconditioning*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <string.h>
+#include <math.h>
+#include "hypamas_ext_internal.h"
+
+#define _GMRES_STAGNATION_RATIO 0.99 /* residual must drop below this ratio of the best one to count as progress */
+#define _GMRES_SINGLE_REDUCE_ETA 1e-2 /* Pythagorean norm is trusted while |w-V*h|^2 > eta*|w|^2 */
+
+int _HypamasGMRESLocalSize(
+    IN__ int restart)
+{
+    int size;
+
+    /*H, cs, sn, g, y, partial sums, reduced sums*/
+    size = (restart + 1) * restart + restart + restart + (restart + 1) + restart + 2 * (restart + 2);
+    return (size + 7) / 8 * 8;
+}
+
+/*sum the partial results of all threads, every thread gets identical sums*/
+static void _GMRESReduce(_HypamasGMRESContext *ctx, _HypamasTeam *team, int tid, int threads, int len, const double *part, double *sum, int *phase)
+{
+    double *buf, s;
+    int k, t;
+
+    buf = ctx->reduce + (size_t)(*phase & 1) * threads * ctx->stride;
+    memcpy(buf + (size_t)tid * ctx->stride, part, sizeof(double) * len);
+    _HypamasTeamBarrier(team, threads);
+    for (k = 0; k < len; ++k)
+    {
+        s = 0.;
+        for (t = 0; t < threads; ++t)
+            s += buf[(size_t)t * ctx->stride + k];
+        sum[k] = s;
+    }
+    ++*phase;
+}
+
+static void _GMRESSpMV(const _HypamasGMRESContext *ctx, int lo, int hi, const double *x, double *y)
+{
+    const double *ax = ctx->ax;
+    const int *ap = ctx->ap, *ai = ctx->ai, *map = ctx->map;
+    double s;
+    int i, p;
+
+    if (NULL != map)
+    {
+        /*CSC values gathered through the map, the rows stay owned by their thread*/
+        for (i = lo; i < hi; ++i)
+        {
+            s = 0.;
+            for (p = ap[i]; p < ap[i + 1]; ++p)
+                s += ax[map[p]] * x[ai[p]];
+            y[i] = s;
+        }
+        return;
+    }
+
+    for (i = lo; i < hi; ++i)
+    {
+        s = 0.;
+        for (p = ap[i]; p < ap[i + 1]; ++p)
+            s += ax[p] * x[ai[p]];
+        y[i] = s;
+    }
+}
+
+/*part[i] = w'*V_i for i <= k, part[k+1] = w'*w if norm is set*/
+static void _GMRESDots(const _HypamasGMRESContext *ctx, int lo, int hi, int k, const double *w, int norm, double *part)
+{
+    const double *vi;
+    double s;
+    int i, r;
+
+    for (i = 0; i <= k; ++i)
+    {
+        vi = ctx->v + (size_t)i * ctx->n;
+        s = 0.;
+        for (r = lo; r < hi; ++r)
+            s += w[r] * vi[r];
+        part[i] = s;
+    }
+    if (norm)
+    {
+        s = 0.;
+        for (r = lo; r < hi; ++r)
+            s += w[r] * w[r];
+        part[k + 1] = s;
+    }
+}
+
+/*w = w - V*h over the first k+1 basis vectors*/
+static void _GMRESProject(const _HypamasGMRESContext *ctx, int lo, int hi, int k, double *w, const double *h)
+{
+    const double *vi;
+    int i, r;
+
+    for (i = 0; i <= k; ++i)
+    {
+        vi = ctx->v + (size_t)i * ctx->n;
+        for (r = lo; r < hi; ++r)
+            w[r] -= h[i] * vi[r];
+    }
+}
+
+/*orthogonalize w against V_0..V_k, h gets the column k of Hessenberg matrix including h[k+1]*/
+static void _GMRESOrthogonalize(_HypamasGMRESContext *ctx, _HypamasTeam *team, int tid, int threads, int lo, int hi,
+                                int k, double *h, double *part, double *sum, int *phase)
+{
+    double *w = ctx->w;
+    double wtw, hth;
+    int i, r;
+
+    switch (ctx->orth)
+    {
+    case kCfgGMRESOrthMGS:
+        /*one reduction per basis vector*/
+        for (i = 0; i <= k; ++i)
+        {
+            const double *vi = ctx->v + (size_t)i * ctx->n;
+            part[0] = 0.;
+            for (r = lo; r < hi; ++r)
+                part[0] += w[r] * vi[r];
+            _GMRESReduce(ctx, team, tid, threads, 1, part, sum, phase);
+            h[i] = sum[0];
+            for (r = lo; r < hi; ++r)
+                w[r] -= h[i] * vi[r];
+        }
+        _GMRESDots(ctx, lo, hi, -1, w, 1, part);
+        _GMRESReduce(ctx, team, tid, threads, 1, part, sum, phase);
+        h[k + 1] = sqrt(sum[0]);
+        return;
+
+    case kCfgGMRESOrthSingleReduce:
+        /*one fused reduction, |w-V*h| by Pythagoras unless cancellation is detected*/
+        _GMRESDots(ctx, lo, hi, k, w, 1, part);
+        _GMRESReduce(ctx, team, tid, threads, k + 2, part, sum, phase);
+        _GMRESProject(ctx, lo, hi, k, w, sum);
+        wtw = sum[k + 1];
+        hth = 0.;
+        for (i = 0; i <= k; ++i)
+        {
+            h[i] = sum[i];
+            hth += sum[i] * sum[i];
+        }
+        if (wtw - hth > _GMRES_SINGLE_REDUCE_ETA * wtw)
+        {
+            h[k + 1] = sqrt(wtw - hth);
+            return;
+        }
+        break;
+
+    default:
+        /*classical Gram-Schmidt, first pass*/
+        _GMRESDots(ctx, lo, hi, k, w, 0, part);
+        _GMRESReduce(ctx, team, tid, threads, k + 1, part, sum, phase);
+        _GMRESProject(ctx, lo, hi, k, w, sum);
+        for (i = 0; i <= k; ++i)
+            h[i] = sum[i];
+        break;
+    }
+
+    /*reorthogonalization, the norm is fused into the same reduction*/
+    _GMRESDots(ctx, lo, hi, k, w, 1, part);
+    _GMRESReduce(ctx, team, tid, threads, k + 2, part, sum, phase);
+    _GMRESProject(ctx, lo, hi, k, w, sum);
+    hth = 0.;
+    for (i = 0; i <= k; ++i)
+    {
+        h[i] += sum[i];
+        hth += sum[i] * sum[i];
+    }
+    h[k + 1] = sqrt(_HYPAMAS_MAX(0., sum[k + 1] - hth));
+}
+
+/*apply the previous rotations to column k and eliminate h[k+1]*/
+static void _GMRESGivens(int k, double *h, double *cs, double *sn, double *g)
+{
+    double t, r;
+    int i;
+
+    for (i = 0; i < k; ++i)
+    {
+        t = cs[i] * h[i] + sn[i] * h[i + 1];
+        h[i + 1] = -sn[i] * h[i] + cs[i] * h[i + 1];
+        h[i] = t;
+    }
+    r = hypot(h[k], h[k + 1]);
+    if (0. == r)
+    {
+        cs[k] = 1.;
+        sn[k] = 0.;
+    }
+    else
+    {
+        cs[k] = h[k] / r;
+        sn[k] = h[k + 1] / r;
+    }
+    h[k] = r;
+    h[k + 1] = 0.;
+    g[k + 1] = -sn[k] * g[k];
+    g[k] = cs[k] * g[k];
+}
+
+static const double *_GMRESPrecond(_HypamasGMRESContext *ctx, _HypamasTeam *team, int tid, int threads, const double *in, int *retval)
+{
+    if (NULL == ctx->precond)
+    {
+        _HypamasTeamBarrier(team, threads);
+        return in;
+    }
+    *retval = ctx->precond(ctx->precond_data, in, ctx->z, team, tid, threads);
+    return ctx->z;
+}
+
+static void _HypamasGMRESProc(void *arg, int tid, int threads)
+{
+    _HypamasGMRESContext *ctx;
+    _HypamasTeam *team;
+    double *local, *H, *cs, *sn, *g, *y, *part, *sum, *h, *v0, *vk, *w, *x;
+    const double *b, *zk;
+    double bnorm, beta, tol, resid, best, s;
+    int n, m, lo, hi, ldh, phase, iter, stall, breakdown, retval, k, i, r;
+
+    ctx = (_HypamasGMRESContext *)arg;
+    team = ctx->team;
+    n = ctx->n;
+    m = ctx->restart;
+    ldh = m + 1;
+    lo = ctx->part[tid];
+    hi = ctx->part[tid + 1];
+
+    local = ctx->local + (size_t)tid * ctx->lstride;
+    H = local;
+    cs = H + (size_t)ldh * m;
+    sn = cs + m;
+    g = sn + m;
+    y = g + m + 1;
+    part = y + m;
+    sum = part + m + 2;
+
+    b = ctx->rhs;
+    x = ctx->sol;
+    w = ctx->w;
+    v0 = ctx->v;
+    phase = 0;
+    iter = 0;
+    stall = 0;
+    retval = kHypamasOK;
+
+    /*r = b - A*x*/
+    _GMRESSpMV(ctx, lo, hi, x, v0);
+    part[0] = part[1] = 0.;
+    for (r = lo; r < hi; ++r)
+    {
+        v0[r] = b[r] - v0[r];
+        part[0] += b[r] * b[r];
+        part[1] += v0[r] * v0[r];
+    }
+    _GMRESReduce(ctx, team, tid, threads, 2, part, sum, &phase);
+    bnorm = sqrt(sum[0]);
+    beta = sqrt(sum[1]);
+
+    if (0. == bnorm)
+    {
+        for (r = lo; r < hi; ++r)
+            x[r] = 0.;
+        goto EXIT;
+    }
+
+    tol = ctx->tol * bnorm;
+    best = beta;
+
+    while (1)
+    {
+        if (beta <= tol)
+            break;
+        if (beta != beta)
+        {
+            retval = kWarningIterationConvergeFail;
+            break;
+        }
+        if (iter >= ctx->maxiter)
+        {
+            retval = kWarningMaxIterationAchieved;
+            break;
+        }
+        if (stall >= ctx->stagnation)
+        {
+            retval = kWarningIterationConvergeSlowly;
+            break;
+        }
+
+        s = 1. / beta;
+        for (r = lo; r < hi; ++r)
+            v0[r] *= s;
+        memset(g, 0, sizeof(double) * (m + 1));
+        g[0] = beta;
+
+        /*Arnoldi process*/
+        k = 0;
+        breakdown = 0;
+        while (k < m && iter < ctx->maxiter)
+        {
+            zk = _GMRESPrecond(ctx, team, tid, threads, ctx->v + (size_t)k * n, &retval);
+            if (FAIL(retval))
+                goto EXIT;
+
+            _GMRESSpMV(ctx, lo, hi, zk, w);
+
+            h = H + (size_t)k * ldh;
+            _GMRESOrthogonalize(ctx, team, tid, threads, lo, hi, k, h, part, sum, &phase);
+
+            if (0. == h[k + 1])
+                breakdown = 1;
+            else
+            {
+                vk = ctx->v + (size_t)(k + 1) * n;
+                s = 1. / h[k + 1];
+                for (r = lo; r < hi; ++r)
+                    vk[r] = w[r] * s;
+            }
+
+            _GMRESGivens(k, h, cs, sn, g);
+            resid = fabs(g[k + 1]);
+            ++k;
+            ++iter;
+
+            if (resid != resid)
+            {
+                retval = kWarningIterationConvergeFail;
+                goto EXIT;
+            }
+            if (resid < _GMRES_STAGNATION_RATIO * best)
+            {
+                best = resid;
+                stall = 0;
+            }
+            else
+                ++stall;
+            if (resid <= tol || breakdown || stall >= ctx->stagnation)
+                break;
+        }
+
+        /*y = inv(H)*g, then x = x + inv(M)*V*y*/
+        for (i = k - 1; i >= 0; --i)
+        {
+            s = g[i];
+            for (r = i + 1; r < k; ++r)
+                s -= H[i + (size_t)r * ldh] * y[r];
+            y[i] = 0. == H[i + (size_t)i * ldh] ? 0. : s / H[i + (size_t)i * ldh];
+        }
+        for (r = lo; r < hi; ++r)
+        {
+            s = 0.;
+            for (i = 0; i < k; ++i)
+                s += y[i] * ctx->v[(size_t)i * n + r];
+            w[r] = s;
+        }
+        zk = _GMRESPrecond(ctx, team, tid, threads, w, &retval);
+        if (FAIL(retval))
+            goto EXIT;
+        for (r = lo; r < hi; ++r)
+            x[r] += zk[r];
+        _HypamasTeamBarrier(team, threads);
+
+        /*true residual of the restart*/
+        _GMRESSpMV(ctx, lo, hi, x, v0);
+        part[0] = 0.;
+        for (r = lo; r < hi; ++r)
+        {
+            v0[r] = b[r] - v0[r];
+            part[0] += v0[r] * v0[r];
+        }
+        _GMRESReduce(ctx, team, tid, threads, 1, part, sum, &phase);
+        beta = sqrt(sum[0]);
+    }
+
+EXIT:
+    if (0 == tid)
+    {
+        ctx->iter = iter;
+        ctx->retval = retval;
+    }
+}
+
+void _HypamasGMRESParallel(
+    INOUT__ _HypamasGMRESContext *ctx,
+    IN__ _HypamasTeam *team,
+    IN__ int threads)
+{
+    ctx->team = team;
+    _HypamasTeamRun(team, threads, _HypamasGMRESProc, ctx);
+}
@@ -0,0 +1,259 @@
+/*used to define ILU(k) of many same-pattern matrices sharing one analysis, values interleaved by instance*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "hypamas_ext_internal.h"
+
+#define _ILU_BATCH_PIVOT_GUARD 1e-6 /* the same as the single instance */
+
+typedef struct
+{
+    _HypamasLevelILU *ilu;
+    _HypamasTeam *team;
+    int wide; /* rows of a level over threads, otherwise instances over threads */
+    double **in;
+    double **out;
+} _ILUBatchArgs;
+
+/*instances [b0, b1) of row k, the innermost loops run over contiguous instances*/
+static void _ILUBatchFactorizeRow(_HypamasLevelILU *ilu, int k, int *pos, int b0, int b1)
+{
+    const int *bp = ilu->bp, *bi = ilu->bi, *diag = ilu->diag;
+    const size_t cnt = ilu->batch;
+    double *bx = ilu->bxb, *lq, *dj, *ur, *xc, d, guard;
+    int q, r, j, c, b;
+
+    for (q = bp[k]; q < bp[k + 1]; ++q)
+        pos[bi[q]] = q;
+
+    for (q = bp[k]; q < diag[k]; ++q)
+    {
+        j = bi[q];
+        lq = bx + q * cnt;
+        dj = bx + diag[j] * cnt;
+        for (b = b0; b < b1; ++b)
+            lq[b] /= dj[b];
+        for (r = diag[j] + 1; r < bp[j + 1]; ++r)
+        {
+            c = pos[bi[r]];
+            if (c < 0)
+                continue;
+            ur = bx + r * cnt;
+            xc = bx + c * cnt;
+            for (b = b0; b < b1; ++b)
+                xc[b] -= lq[b] * ur[b];
+        }
+    }
+
+    dj = bx + diag[k] * cnt;
+    for (b = b0; b < b1; ++b)
+    {
+        d = dj[b];
+        guard = _ILU_BATCH_PIVOT_GUARD * ilu->rowmaxb[k * cnt + b];
+        if (fabs(d) < guard || 0. == d)
+            dj[b] = 0. == guard ? 1. : (d < 0. ? -guard : guard);
+    }
+
+    for (q = bp[k]; q < bp[k + 1]; ++q)
+        pos[bi[q]] = -1;
+}
+
+static void _ILUBatchFactorizeProc(void *arg, int tid, int threads)
+{
+    _ILUBatchArgs *args = (_ILUBatchArgs *)arg;
+    _HypamasLevelILU *ilu = args->ilu;
+    int *pos, lev, lo, hi, cnt, i, b0, b1;
+
+    pos = ilu->pos + (size_t)tid * ilu->n;
+
+    if (!args->wide)
+    {
+        b0 = (int)((long long)ilu->batch * tid / threads);
+        b1 = (int)((long long)ilu->batch * (tid + 1) / threads);
+        for (i = 0; i < ilu->n && b0 < b1; ++i)
+            _ILUBatchFactorizeRow(ilu, i, pos, b0, b1);
+        return;
+    }
+
+    for (lev = 0; lev < ilu->lnum; ++lev)
+    {
+        cnt = ilu->lptr[lev + 1] - ilu->lptr[lev];
+        lo = ilu->lptr[lev] + (int)((long long)cnt * tid / threads);
+        hi = ilu->lptr[lev] + (int)((long long)cnt * (tid + 1) / threads);
+        for (i = lo; i < hi; ++i)
+            _ILUBatchFactorizeRow(ilu, ilu->lrows[i], pos, 0, ilu->batch);
+        _HypamasTeamBarrier(args->team, threads);
+    }
+}
+
+int _HypamasLevelILUBatchNumeric(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int count,
+    IN__ double **ax,
+    IN__ int threads)
+{
+    _ILUBatchArgs args;
+    _HypamasTeam *team;
+    double *bxb, *rowmaxb, *workb, v;
+    int k, q, b, retval;
+    size_t cnt;
+
+    args.wide = _HypamasLevelILUWide(ilu, threads);
+    if (!args.wide)
+        threads = _HYPAMAS_MAX(1, _HYPAMAS_MIN(threads, count));
+
+    cnt = count;
+    if (count != ilu->batch)
+    {
+        bxb = (double *)_HypamasRealloc(ilu->bxb, sizeof(double) * ilu->bp[ilu->n] * cnt);
+        if (NULL != bxb)
+            ilu->bxb = bxb;
+        rowmaxb = (double *)_HypamasRealloc(ilu->rowmaxb, sizeof(double) * ilu->n * cnt);
+        if (NULL != rowmaxb)
+            ilu->rowmaxb = rowmaxb;
+        workb = (double *)_HypamasRealloc(ilu->workb, sizeof(double) * ilu->n * cnt);
+        if (NULL != workb)
+            ilu->workb = workb;
+        ilu->batch = 0;
+        if (NULL == bxb || NULL == rowmaxb || NULL == workb)
+            return kErrorOutOfMemory;
+    }
+    retval = _HypamasLevelILUPos(ilu, threads);
+    if (FAIL(retval))
+        return retval;
+
+    /*interleave the values, entry q of instance b at q*count+b*/
+    for (k = 0; k < ilu->n; ++k)
+    {
+        for (b = 0; b < count; ++b)
+            ilu->rowmaxb[k * cnt + b] = 0.;
+        for (q = ilu->bp[k]; q < ilu->bp[k + 1]; ++q)
+        {
+            for (b = 0; b < count; ++b)
+            {
+                v = ilu->map[q] >= 0 ? ax[b][ilu->map[q]] : 0.;
+                ilu->bxb[q * cnt + b] = v;
+                ilu->rowmaxb[k * cnt + b] = _HYPAMAS_MAX(ilu->rowmaxb[k * cnt + b], fabs(v));
+            }
+        }
+    }
+    ilu->batch = count;
+
+    retval = _HypamasTeamAcquire(&team, threads);
+    if (FAIL(retval))
+        return retval;
+    args.ilu = ilu;
+    args.team = team;
+    _HypamasTeamRun(team, threads, _ILUBatchFactorizeProc, &args);
+    _HypamasTeamRelease(team);
+
+    return kHypamasOK;
+}
+
+static void _ILUBatchForwardRow(const _HypamasLevelILU *ilu, int k, double **in, int b0, int b1)
+{
+    const size_t cnt = ilu->batch;
+    const double *lq, *yj;
+    double *y = ilu->workb, *yk;
+    int q, b;
+
+    yk = y + k * cnt;
+    for (b = b0; b < b1; ++b)
+        yk[b] = in[b][ilu->perm[k]];
+    for (q = ilu->bp[k]; q < ilu->diag[k]; ++q)
+    {
+        lq = ilu->bxb + q * cnt;
+        yj = y + ilu->bi[q] * cnt;
+        for (b = b0; b < b1; ++b)
+            yk[b] -= lq[b] * yj[b];
+    }
+}
+
+static void _ILUBatchBackwardRow(const _HypamasLevelILU *ilu, int k, double **out, int b0, int b1)
+{
+    const size_t cnt = ilu->batch;
+    const double *uq, *yj, *dk;
+    double *y = ilu->workb, *yk;
+    int q, b;
+
+    yk = y + k * cnt;
+    for (q = ilu->diag[k] + 1; q < ilu->bp[k + 1]; ++q)
+    {
+        uq = ilu->bxb + q * cnt;
+        yj = y + ilu->bi[q] * cnt;
+        for (b = b0; b < b1; ++b)
+            yk[b] -= uq[b] * yj[b];
+    }
+    dk = ilu->bxb + ilu->diag[k] * cnt;
+    for (b = b0; b < b1; ++b)
+    {
+        yk[b] /= dk[b];
+        out[b][k] = yk[b];
+    }
+}
+
+static void _ILUBatchSolveProc(void *arg, int tid, int threads)
+{
+    _ILUBatchArgs *args = (_ILUBatchArgs *)arg;
+    const _HypamasLevelILU *ilu = args->ilu;
+    int lev, lo, hi, cnt, i, k, b0, b1;
+
+    if (!args->wide)
+    {
+        b0 = (int)((long long)ilu->batch * tid / threads);
+        b1 = (int)((long long)ilu->batch * (tid + 1) / threads);
+        if (b0 == b1)
+            return;
+        for (k = 0; k < ilu->n; ++k)
+            _ILUBatchForwardRow(ilu, k, args->in, b0, b1);
+        for (k = ilu->n - 1; k >= 0; --k)
+            _ILUBatchBackwardRow(ilu, k, args->out, b0, b1);
+        return;
+    }
+
+    for (lev = 0; lev < ilu->lnum; ++lev)
+    {
+        cnt = ilu->lptr[lev + 1] - ilu->lptr[lev];
+        lo = ilu->lptr[lev] + (int)((long long)cnt * tid / threads);
+        hi = ilu->lptr[lev] + (int)((long long)cnt * (tid + 1) / threads);
+        for (i = lo; i < hi; ++i)
+            _ILUBatchForwardRow(ilu, ilu->lrows[i], args->in, 0, ilu->batch);
+        _HypamasTeamBarrier(args->team, threads);
+    }
+    for (lev = 0; lev < ilu->unum; ++lev)
+    {
+        cnt = ilu->uptr[lev + 1] - ilu->uptr[lev];
+        lo = ilu->uptr[lev] + (int)((long long)cnt * tid / threads);
+        hi = ilu->uptr[lev] + (int)((long long)cnt * (tid + 1) / threads);
+        for (i = lo; i < hi; ++i)
+            _ILUBatchBackwardRow(ilu, ilu->urows[i], args->out, 0, ilu->batch);
+        _HypamasTeamBarrier(args->team, threads);
+    }
+}
+
+int _HypamasLevelILUBatchSolve(
+    IN__ _HypamasLevelILU *ilu,
+    IN__ double **in,
+    OUT__ double **out,
+    IN__ int threads)
+{
+    _ILUBatchArgs args;
+    int retval;
+
+    args.wide = _HypamasLevelILUWide(ilu, threads);
+    if (!args.wide)
+        threads = _HYPAMAS_MAX(1, _HYPAMAS_MIN(threads, ilu->batch));
+    args.ilu = ilu;
+    args.in = in;
+    args.out = out;
+
+    retval = _HypamasTeamAcquire(&args.team, threads);
+    if (FAIL(retval))
+        return retval;
+    _HypamasTeamRun(args.team, threads, _ILUBatchSolveProc, &args);
+    _HypamasTeamRelease(args.team);
+
+    return kHypamasOK;
+}
@@ -0,0 +1,1515 @@
+/*used to define ILU(k) with level-scheduled factorization and triangular solves*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <sched.h>
+#include <immintrin.h>
+#include <sys/mman.h>
+#include "hypamas_ext_internal.h"
+
+#define _ILU_PIVOT_GUARD 1e-6 /* pivots below this ratio of the row maximum are perturbed */
+#define _ILU_LEVEL_WIDTH 32   /* minimum average rows per level and thread to run level-scheduled */
+#define _ILU_STEAL_ROWS 64    /* minimum rows per thread to run by work stealing */
+#define _ILU_SYMBOLIC_NNZ_PER_THREAD 65536 /* minimum non-zeros per thread of the analysis */
+#define _ILU_SYMBOLIC_BLOCK 64  /* rows of a block of the pipelined fill & levels, blocks go round robin over threads */
+#define _ILU_FILL_CHUNK 65536   /* ints of a block of rows stored by a thread of the fill */
+#define _ILU_SPIN_COUNT 4000    /* pause rounds of a thread waiting for a row before yielding the core */
+#define _ILU_NEAR_LOWER 1       /* in bd[diag[k]]: every column of the strict L of row k is within 16 bits of k */
+#define _ILU_NEAR_UPPER 2       /* the same for the strict U */
+
+/*CSR view of the input with map to the position in ax, transposed by threads if the input is CSC*/
+static int _ILUCSRView(int n, const int *ap, const int *ai, int mode, int **rp, int **ri, int **rmap, int threads)
+{
+    int nnz, p;
+
+    nnz = ap[n];
+    *rp = (int *)_HypamasMalloc(sizeof(int) * (n + 1));
+    *ri = (int *)_HypamasMalloc(sizeof(int) * nnz);
+    *rmap = (int *)_HypamasMalloc(sizeof(int) * nnz);
+    if (NULL == *rp || NULL == *ri || NULL == *rmap)
+        return kErrorOutOfMemory;
+
+    if (0 != mode)
+        return _HypamasTranspose(n, ap, ap + 1, ai, NULL, *rp, *ri, NULL, *rmap, threads);
+
+    memcpy(*rp, ap, sizeof(int) * (n + 1));
+    memcpy(*ri, ai, sizeof(int) * nnz);
+    for (p = 0; p < nnz; ++p)
+        (*rmap)[p] = p;
+    return kHypamasOK;
+}
+
+/*binary heap of rows keyed by distance*/
+static void _ILUHeapUp(int *heap, int *hpos, const double *d, int k)
+{
+    int i = heap[k];
+
+    while (k > 0 && d[heap[(k - 1) / 2]] > d[i])
+    {
+        heap[k] = heap[(k - 1) / 2];
+        hpos[heap[k]] = k;
+        k = (k - 1) / 2;
+    }
+    heap[k] = i;
+    hpos[i] = k;
+}
+
+static int _ILUHeapPop(int *heap, int *hpos, const double *d, int *size)
+{
+    int top, i, k, c;
+
+    top = heap[0];
+    hpos[top] = -1;
+    i = heap[--*size];
+    k = 0;
+    while ((c = 2 * k + 1) < *size)
+    {
+        if (c + 1 < *size && d[heap[c + 1]] < d[heap[c]])
+            ++c;
+        if (d[heap[c]] >= d[i])
+            break;
+        heap[k] = heap[c];
+        hpos[heap[k]] = k;
+        k = c;
+    }
+    if (*size > 0)
+    {
+        heap[k] = i;
+        hpos[i] = k;
+    }
+    return top;
+}
+
+/*row matched to each column maximizing the product of the matched entries, by shortest augmenting paths*/
+/*cost of an entry is log(max of the column) - log|a|, u & v are the dual variables of rows & columns*/
+static int _ILUMatch(int n, const int *rp, const int *ri, const int *rmap, const double *ax, int *rowof)
+{
+    int *cp, *ci, *colof, *heap, *hpos, *pred, *done, *count;
+    double *cost, *u, *v, *d, *cmax, w, dist;
+    int i, j, j0, p, q, k, size, ndone, found, retval;
+
+    cp = (int *)_HypamasCalloc(n + 1, sizeof(int));
+    ci = (int *)_HypamasMalloc(sizeof(int) * (rp[n] + 1));
+    cost = (double *)_HypamasMalloc(sizeof(double) * (rp[n] + 1));
+    colof = (int *)_HypamasMalloc(sizeof(int) * n);
+    heap = (int *)_HypamasMalloc(sizeof(int) * n);
+    hpos = (int *)_HypamasMalloc(sizeof(int) * n);
+    pred = (int *)_HypamasMalloc(sizeof(int) * n);
+    done = (int *)_HypamasMalloc(sizeof(int) * n);
+    count = (int *)_HypamasMalloc(sizeof(int) * n);
+    u = (double *)_HypamasCalloc(n, sizeof(double));
+    v = (double *)_HypamasCalloc(n, sizeof(double));
+    d = (double *)_HypamasMalloc(sizeof(double) * n);
+    cmax = (double *)_HypamasCalloc(n, sizeof(double));
+    if (NULL == cp || NULL == ci || NULL == cost || NULL == colof || NULL == heap || NULL == hpos || NULL == pred ||
+        NULL == done || NULL == count || NULL == u || NULL == v || NULL == d || NULL == cmax)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+
+    /*columns of the pattern, explicit zeros are not matched*/
+    for (p = 0; p < rp[n]; ++p)
+    {
+        w = fabs(ax[rmap[p]]);
+        if (w > 0.)
+        {
+            ++cp[ri[p] + 1];
+            cmax[ri[p]] = _HYPAMAS_MAX(cmax[ri[p]], w);
+        }
+    }
+    for (j = 0; j < n; ++j)
+        cp[j + 1] += cp[j];
+    memcpy(count, cp, sizeof(int) * n);
+    for (i = 0; i < n; ++i)
+    {
+        for (p = rp[i]; p < rp[i + 1]; ++p)
+        {
+            w = fabs(ax[rmap[p]]);
+            if (w > 0.)
+            {
+                q = count[ri[p]]++;
+                ci[q] = i;
+                cost[q] = log(cmax[ri[p]]) - log(w);
+            }
+        }
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        colof[i] = -1;
+        rowof[i] = -1;
+        hpos[i] = -1;
+        d[i] = HUGE_VAL;
+    }
+
+    /*cheap assignment of the entries with zero cost*/
+    for (j = 0; j < n; ++j)
+    {
+        for (q = cp[j]; q < cp[j + 1]; ++q)
+        {
+            if (0. == cost[q] && -1 == colof[ci[q]])
+            {
+                colof[ci[q]] = j;
+                rowof[j] = ci[q];
+                break;
+            }
+        }
+    }
+
+    for (j0 = 0; j0 < n; ++j0)
+    {
+        if (rowof[j0] >= 0)
+            continue;
+
+        /*Dijkstra over rows from the free column j0*/
+        size = 0;
+        ndone = 0;
+        found = -1;
+        dist = HUGE_VAL;
+        j = j0;
+        w = 0.;
+        while (1)
+        {
+            for (q = cp[j]; q < cp[j + 1]; ++q)
+            {
+                i = ci[q];
+                if (HUGE_VAL != d[i] && hpos[i] < 0)
+                    continue; /* finalized */
+                if (w + cost[q] - u[i] - v[j] < d[i])
+                {
+                    d[i] = w + cost[q] - u[i] - v[j];
+                    pred[i] = j;
+                    if (hpos[i] < 0)
+                    {
+                        heap[size] = i;
+                        hpos[i] = size++;
+                    }
+                    _ILUHeapUp(heap, hpos, d, hpos[i]);
+                }
+            }
+            if (0 == size)
+                break;
+            i = _ILUHeapPop(heap, hpos, d, &size);
+            done[ndone++] = i;
+            if (-1 == colof[i])
+            {
+                found = i;
+                dist = d[i];
+                break;
+            }
+            j = colof[i];
+            w = d[i];
+        }
+        if (found < 0)
+        {
+            retval = kErrorMatrixStructuralSingular;
+            goto FINAL;
+        }
+
+        /*dual update keeps the reduced costs non-negative and the matched ones zero*/
+        v[j0] += dist;
+        for (k = 0; k < ndone; ++k)
+        {
+            i = done[k];
+            if (d[i] < dist)
+            {
+                u[i] -= dist - d[i];
+                v[colof[i]] += dist - d[i];
+            }
+        }
+
+        /*flip the path*/
+        i = found;
+        while (1)
+        {
+            j = pred[i];
+            k = rowof[j];
+            rowof[j] = i;
+            colof[i] = j;
+            if (j == j0)
+                break;
+            i = k;
+        }
+
+        /*reset the rows touched*/
+        for (k = 0; k < ndone; ++k)
+            d[done[k]] = HUGE_VAL;
+        for (k = 0; k < size; ++k)
+        {
+            d[heap[k]] = HUGE_VAL;
+            hpos[heap[k]] = -1;
+        }
+    }
+    retval = kHypamasOK;
+
+FINAL:
+
+    _HypamasFree(cp);
+    _HypamasFree(ci);
+    _HypamasFree(cost);
+    _HypamasFree(colof);
+    _HypamasFree(heap);
+    _HypamasFree(hpos);
+    _HypamasFree(pred);
+    _HypamasFree(done);
+    _HypamasFree(count);
+    _HypamasFree(u);
+    _HypamasFree(v);
+    _HypamasFree(d);
+    _HypamasFree(cmax);
+
+    return retval;
+}
+
+/*Run a pass of the analysis on threads, or on the calling thread alone.*/
+static int _ILUSymbolicRun(_HypamasTaskProc proc, void *arg, int threads)
+{
+    _HypamasTeam *team;
+    int retval;
+
+    if (threads <= 1)
+    {
+        proc(arg, 0, 1);
+        return kHypamasOK;
+    }
+    retval = _HypamasTeamAcquire(&team, threads);
+    if (FAIL(retval))
+        return retval;
+    _HypamasTeamRun(team, threads, proc, arg);
+    _HypamasTeamRelease(team);
+    return kHypamasOK;
+}
+
+/*One round of waiting for a row of a pipelined pass stored by another thread.*/
+static void _ILUSpin(int *spin)
+{
+    if (++*spin < _ILU_SPIN_COUNT)
+        _mm_pause();
+    else
+        sched_yield();
+}
+
+/**
+ * @brief Rows of the level of fill stored by the thread computing them, in blocks never moved while other threads read them
+ */
+typedef struct _ILUFillChunk
+{
+    struct _ILUFillChunk *next;
+    int data[1];
+} _ILUFillChunk;
+
+typedef struct
+{
+    _ILUFillChunk *chunks;
+    int *free; /* unused ints of the last chunk */
+    size_t left;
+    char pad[40];
+} _ILUFillStore;
+
+typedef struct
+{
+    _HypamasLevelILU *ilu;
+    int fill;
+    int threads;
+    int **row;   /* columns, levels & maps of row k as 3 runs of cnt[k], published last, NULL until stored */
+    int *cnt;
+    int *dpos;   /* offset of the diagonal in row k */
+    int *work;   /* link & lev, 2n+1 per thread */
+    _ILUFillStore *store;
+    int *fp;     /* CSR of the result, filled from the rows after the pipeline */
+    int *fi;
+    int *fmap;
+    int *diag;
+    int failed;  /* a thread ran out of memory, the others stop waiting */
+} _ILUFillArgs;
+
+static int *_ILUFillAlloc(_ILUFillStore *store, size_t size)
+{
+    _ILUFillChunk *chunk;
+    size_t cap;
+    int *p;
+
+    if (store->left < size)
+    {
+        cap = _HYPAMAS_MAX((size_t)_ILU_FILL_CHUNK, size);
+        chunk = (_ILUFillChunk *)_HypamasMalloc(sizeof(_ILUFillChunk) + sizeof(int) * (cap - 1));
+        if (NULL == chunk)
+            return NULL;
+        chunk->next = store->chunks;
+        store->chunks = chunk;
+        store->free = chunk->data;
+        store->left = cap;
+    }
+    p = store->free;
+    store->free += size;
+    store->left -= size;
+    return p;
+}
+
+/*Level of fill of the rows of the blocks of thread tid, a row waits for the rows of its L as they are reached.*/
+/*Row k only reads finished rows j < k, so the pattern does not depend on threads.*/
+static void _ILUFillProc(void *arg, int tid, int threads)
+{
+    _ILUFillArgs *args = (_ILUFillArgs *)arg;
+    _HypamasLevelILU *ilu = args->ilu;
+    const int n = ilu->n, fill = args->fill;
+    int *link, *lev, *rj, *rk;
+    int b, k, q, j, c, cj, prev, head, cnt, newlev, spin;
+
+    link = args->work + (size_t)tid * (2 * n + 1);
+    lev = link + n + 1;
+    for (k = 0; k < n; ++k)
+        lev[k] = -1;
+
+    for (b = tid * _ILU_SYMBOLIC_BLOCK; b < n; b += threads * _ILU_SYMBOLIC_BLOCK)
+    {
+        for (k = b; k < _HYPAMAS_MIN(b + _ILU_SYMBOLIC_BLOCK, n); ++k)
+        {
+            /*sorted linked list of the row, n ends the list*/
+            head = n;
+            for (q = ilu->bp[k + 1] - 1; q >= ilu->bp[k]; --q)
+            {
+                c = ilu->bi[q];
+                link[c] = head;
+                lev[c] = 0;
+                head = c;
+            }
+
+            for (j = head; j < k; j = link[j])
+            {
+                spin = 0;
+                while (NULL == (rj = __atomic_load_n(&args->row[j], __ATOMIC_ACQUIRE)))
+                {
+                    if (__atomic_load_n(&args->failed, __ATOMIC_RELAXED))
+                        return;
+                    _ILUSpin(&spin);
+                }
+                cj = args->cnt[j];
+                prev = j;
+                for (q = args->dpos[j] + 1; q < cj; ++q)
+                {
+                    c = rj[q];
+                    newlev = lev[j] + rj[cj + q] + 1;
+                    if (newlev > fill)
+                        continue;
+                    if (lev[c] >= 0)
+                    {
+                        lev[c] = _HYPAMAS_MIN(lev[c], newlev);
+                        continue;
+                    }
+                    while (link[prev] < c)
+                        prev = link[prev];
+                    link[c] = link[prev];
+                    link[prev] = c;
+                    lev[c] = newlev;
+                    prev = c;
+                }
+            }
+
+            cnt = 0;
+            for (j = head; j < n; j = link[j])
+                ++cnt;
+            rk = _ILUFillAlloc(args->store + tid, (size_t)cnt * 3);
+            if (NULL == rk)
+            {
+                __atomic_store_n(&args->failed, 1, __ATOMIC_RELAXED);
+                return;
+            }
+
+            /*original entries keep their map, both lists are sorted*/
+            q = 0;
+            c = ilu->bp[k];
+            for (j = head; j < n; j = link[j], ++q)
+            {
+                rk[q] = j;
+                rk[cnt + q] = lev[j];
+                rk[2 * cnt + q] = -1;
+                if (c < ilu->bp[k + 1] && ilu->bi[c] == j)
+                    rk[2 * cnt + q] = ilu->map[c++];
+                if (j == k)
+                    args->dpos[k] = q;
+                lev[j] = -1;
+            }
+            args->cnt[k] = cnt;
+            __atomic_store_n(&args->row[k], rk, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/*Copy the rows of the pipeline into the CSR of the factors.*/
+static void _ILUFillCopyProc(void *arg, int tid, int threads)
+{
+    _ILUFillArgs *args = (_ILUFillArgs *)arg;
+    const int n = args->ilu->n;
+    int k, cnt;
+
+    for (k = (int)((long long)n * tid / threads); k < (int)((long long)n * (tid + 1) / threads); ++k)
+    {
+        cnt = args->cnt[k];
+        memcpy(args->fi + args->fp[k], args->row[k], sizeof(int) * cnt);
+        memcpy(args->fmap + args->fp[k], args->row[k] + 2 * cnt, sizeof(int) * cnt);
+        args->diag[k] = args->fp[k] + args->dpos[k];
+    }
+}
+
+/*pattern of ILU(fill) by levels of fill, replacing the pattern of B, entries not in A have map -1*/
+/*Blocks of rows go round robin over threads, pipelined on the rows each row depends on.*/
+static int _ILUFill(_HypamasLevelILU *ilu, int fill, int threads)
+{
+    _ILUFillArgs args;
+    _ILUFillChunk *chunk;
+    long long nnz;
+    int n, k, t, retval;
+
+    n = ilu->n;
+    threads = _HYPAMAS_MAX(1, _HYPAMAS_MIN(threads, (n + _ILU_SYMBOLIC_BLOCK - 1) / _ILU_SYMBOLIC_BLOCK));
+    memset(&args, 0, sizeof(args));
+    args.ilu = ilu;
+    args.fill = fill;
+    args.threads = threads;
+    args.row = (int **)_HypamasCalloc(n, sizeof(int *));
+    args.cnt = (int *)_HypamasMalloc(sizeof(int) * n);
+    args.dpos = (int *)_HypamasMalloc(sizeof(int) * n);
+    args.work = (int *)_HypamasMalloc(sizeof(int) * (2 * (size_t)n + 1) * threads);
+    args.store = (_ILUFillStore *)_HypamasCalloc(threads, sizeof(_ILUFillStore));
+    args.fp = (int *)_HypamasMalloc(sizeof(int) * (n + 1));
+    args.diag = (int *)_HypamasMalloc(sizeof(int) * n);
+    if (NULL == args.row || NULL == args.cnt || NULL == args.dpos || NULL == args.work || NULL == args.store ||
+        NULL == args.fp || NULL == args.diag)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+
+    retval = _ILUSymbolicRun(_ILUFillProc, &args, threads);
+    if (FAIL(retval))
+        goto FINAL;
+    if (args.failed)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+
+    nnz = 0;
+    args.fp[0] = 0;
+    for (k = 0; k < n; ++k)
+    {
+        nnz += args.cnt[k];
+        if (nnz > INT_MAX)
+        {
+            retval = kErrordOverflow;
+            goto FINAL;
+        }
+        args.fp[k + 1] = (int)nnz;
+    }
+    args.fi = (int *)_HypamasMalloc(sizeof(int) * (nnz + 1));
+    args.fmap = (int *)_HypamasMalloc(sizeof(int) * (nnz + 1));
+    if (NULL == args.fi || NULL == args.fmap)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+    retval = _ILUSymbolicRun(_ILUFillCopyProc, &args, threads);
+    if (FAIL(retval))
+        goto FINAL;
+
+    _HypamasFree(ilu->bp);
+    _HypamasFree(ilu->bi);
+    _HypamasFree(ilu->map);
+    _HypamasFree(ilu->diag);
+    ilu->bp = args.fp;
+    ilu->bi = args.fi;
+    ilu->map = args.fmap;
+    ilu->diag = args.diag;
+    args.fp = NULL;
+    args.fi = NULL;
+    args.fmap = NULL;
+    args.diag = NULL;
+
+FINAL:
+
+    for (t = 0; NULL != args.store && t < threads; ++t)
+    {
+        while (NULL != (chunk = args.store[t].chunks))
+        {
+            args.store[t].chunks = chunk->next;
+            _HypamasFree(chunk);
+        }
+    }
+    _HypamasFree(args.row);
+    _HypamasFree(args.cnt);
+    _HypamasFree(args.dpos);
+    _HypamasFree(args.work);
+    _HypamasFree(args.store);
+    _HypamasFree(args.fp);
+    _HypamasFree(args.fi);
+    _HypamasFree(args.fmap);
+    _HypamasFree(args.diag);
+
+    return retval;
+}
+
+typedef struct
+{
+    const _HypamasLevelILU *ilu;
+    int upper;
+    int *level; /* -1 until the level of the row is stored */
+} _ILULevelsArgs;
+
+/*Level of the rows of the blocks of thread tid in the order of the pass, a row waits for the rows it depends on.*/
+static void _ILULevelsProc(void *arg, int tid, int threads)
+{
+    _ILULevelsArgs *args = (_ILULevelsArgs *)arg;
+    const _HypamasLevelILU *ilu = args->ilu;
+    const int n = ilu->n;
+    int *level = args->level;
+    int b, i, row, q, lo, hi, lev, dep, spin;
+
+    for (b = tid * _ILU_SYMBOLIC_BLOCK; b < n; b += threads * _ILU_SYMBOLIC_BLOCK)
+    {
+        for (i = b; i < _HYPAMAS_MIN(b + _ILU_SYMBOLIC_BLOCK, n); ++i)
+        {
+            row = args->upper ? n - 1 - i : i;
+            lo = args->upper ? ilu->diag[row] + 1 : ilu->bp[row];
+            hi = args->upper ? ilu->bp[row + 1] : ilu->diag[row];
+            lev = 0;
+            for (q = lo; q < hi; ++q)
+            {
+                spin = 0;
+                while ((dep = __atomic_load_n(&level[ilu->bi[q]], __ATOMIC_ACQUIRE)) < 0)
+                    _ILUSpin(&spin);
+                lev = _HYPAMAS_MAX(lev, dep + 1);
+            }
+            __atomic_store_n(&level[row], lev, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/*level sets: L levels by ascending rows, U levels by descending rows*/
+/*The levels are computed on threads like the fill, the rows of a level are in the order of the pass.*/
+static int _ILULevels(_HypamasLevelILU *ilu, int upper, int threads)
+{
+    _ILULevelsArgs args;
+    int n, k, num, retval;
+    int *level, *ptr, *rows;
+
+    n = ilu->n;
+    level = (int *)_HypamasMalloc(sizeof(int) * n);
+    ptr = (int *)_HypamasCalloc(n + 1, sizeof(int));
+    rows = (int *)_HypamasMalloc(sizeof(int) * n);
+    if (NULL == level || NULL == ptr || NULL == rows)
+    {
+        _HypamasFree(level);
+        _HypamasFree(ptr);
+        _HypamasFree(rows);
+        return kErrorOutOfMemory;
+    }
+
+    for (k = 0; k < n; ++k)
+        level[k] = -1;
+    args.ilu = ilu;
+    args.upper = upper;
+    args.level = level;
+    threads = _HYPAMAS_MAX(1, _HYPAMAS_MIN(threads, (n + _ILU_SYMBOLIC_BLOCK - 1) / _ILU_SYMBOLIC_BLOCK));
+    retval = _ILUSymbolicRun(_ILULevelsProc, &args, threads);
+    if (FAIL(retval))
+    {
+        _HypamasFree(level);
+        _HypamasFree(ptr);
+        _HypamasFree(rows);
+        return retval;
+    }
+
+    num = 0;
+    for (k = 0; k < n; ++k)
+    {
+        ++ptr[level[k] + 1];
+        num = _HYPAMAS_MAX(num, level[k] + 1);
+    }
+    for (k = 0; k < num; ++k)
+        ptr[k + 1] += ptr[k];
+    for (k = 0; k < n; ++k)
+    {
+        int row = upper ? n - 1 - k : k;
+        rows[ptr[level[row]]++] = row;
+    }
+    for (k = num; k > 0; --k)
+        ptr[k] = ptr[k - 1];
+    ptr[0] = 0;
+
+    _HypamasFree(level);
+    if (upper)
+    {
+        ilu->unum = num;
+        ilu->uptr = ptr;
+        ilu->urows = rows;
+    }
+    else
+    {
+        ilu->lnum = num;
+        ilu->lptr = ptr;
+        ilu->lrows = rows;
+    }
+    return kHypamasOK;
+}
+
+void _HypamasLevelILUFree(
+    INOUT__ _HypamasLevelILU *ilu)
+{
+    int fill, precision, schedule, exact;
+
+    fill = ilu->fill;
+    precision = ilu->precision;
+    schedule = ilu->schedule;
+    exact = ilu->exact;
+    if (NULL != ilu->mapped)
+    {
+        munmap(ilu->mapped, ilu->mapped_size);
+    }
+    else
+    {
+        _HypamasFree(ilu->perm);
+        _HypamasFree(ilu->map);
+        _HypamasFree(ilu->bp);
+        _HypamasFree(ilu->bi);
+        _HypamasFree(ilu->diag);
+        _HypamasFree(ilu->lptr);
+        _HypamasFree(ilu->lrows);
+        _HypamasFree(ilu->uptr);
+        _HypamasFree(ilu->urows);
+    }
+    _HypamasFree(ilu->rp);
+    _HypamasFree(ilu->ri);
+    _HypamasFree(ilu->rmap);
+    _HypamasFree(ilu->bx);
+    _HypamasFree(ilu->rowmax);
+    _HypamasFree(ilu->pos);
+    _HypamasFree(ilu->work);
+    _HypamasFree(ilu->bxb);
+    _HypamasFree(ilu->rowmaxb);
+    _HypamasFree(ilu->workb);
+    _HypamasFree(ilu->bxs);
+    _HypamasFree(ilu->bd);
+    _HypamasFree(ilu->lsp);
+    _HypamasFree(ilu->lsi);
+    _HypamasFree(ilu->ldeg);
+    _HypamasTaskGraphFree(ilu->graph);
+    _HypamasLevelILUSparseFree(ilu->sparse);
+    memset(ilu, 0, sizeof(_HypamasLevelILU));
+    ilu->fill = fill;
+    ilu->precision = precision;
+    ilu->schedule = schedule;
+    ilu->exact = exact;
+}
+
+int _HypamasLevelILUAllocNumeric(
+    INOUT__ _HypamasLevelILU *ilu)
+{
+    long long d;
+    int k, q, near;
+
+    _HypamasFree(ilu->bx);
+    _HypamasFree(ilu->bxs);
+    ilu->bx = NULL;
+    ilu->bxs = NULL;
+    if (kCfgILUPrecisionSingle == ilu->precision)
+        ilu->bxs = (float *)_HypamasMalloc(sizeof(float) * ilu->bp[ilu->n]);
+    else
+        ilu->bx = (double *)_HypamasMalloc(sizeof(double) * ilu->bp[ilu->n]);
+    if (NULL == ilu->rowmax)
+        ilu->rowmax = (double *)_HypamasMalloc(sizeof(double) * ilu->n);
+    if (NULL == ilu->work)
+        ilu->work = (double *)_HypamasMalloc(sizeof(double) * ilu->n);
+    if ((NULL == ilu->bx && NULL == ilu->bxs) || NULL == ilu->rowmax || NULL == ilu->work)
+        return kErrorOutOfMemory;
+    if (NULL != ilu->bd)
+        return kHypamasOK;
+
+    /*distance of each column to the diagonal, the unused diagonal slot flags the parts of the row held entirely in 16 bits*/
+    ilu->bd = (unsigned short *)_HypamasMalloc(sizeof(unsigned short) * ilu->bp[ilu->n]);
+    if (NULL == ilu->bd)
+        return kErrorOutOfMemory;
+    for (k = 0; k < ilu->n; ++k)
+    {
+        near = _ILU_NEAR_LOWER | _ILU_NEAR_UPPER;
+        for (q = ilu->bp[k]; q < ilu->bp[k + 1]; ++q)
+        {
+            d = ilu->bi[q] < k ? (long long)k - ilu->bi[q] : (long long)ilu->bi[q] - k;
+            ilu->bd[q] = d <= USHRT_MAX ? (unsigned short)d : 0;
+            if (d > USHRT_MAX)
+                near &= ilu->bi[q] < k ? ~_ILU_NEAR_LOWER : ~_ILU_NEAR_UPPER;
+        }
+        ilu->bd[ilu->diag[k]] = (unsigned short)near;
+    }
+
+    return kHypamasOK;
+}
+
+typedef struct
+{
+    _HypamasLevelILU *ilu;
+    const int *rp; /* CSR view of A */
+    const int *ri;
+    const int *rmap;
+    const int *part; /* rows of each thread */
+    int singular;    /* set if a row has no diagonal */
+} _ILUAssembleArgs;
+
+/*Rows of B from the CSR view of A, columns sorted.*/
+static void _ILUAssembleProc(void *arg, int tid, int threads)
+{
+    _ILUAssembleArgs *args = (_ILUAssembleArgs *)arg;
+    _HypamasLevelILU *ilu = args->ilu;
+    int k, p, q, r, c, m;
+    (void)threads;
+
+    for (k = args->part[tid]; k < args->part[tid + 1]; ++k)
+    {
+        r = ilu->perm[k];
+        for (p = args->rp[r]; p < args->rp[r + 1]; ++p)
+        {
+            q = ilu->bp[k] + (p - args->rp[r]);
+            c = args->ri[p];
+            m = args->rmap[p];
+            /*insertion sort, rows of circuit matrices are short*/
+            for (; q > ilu->bp[k] && ilu->bi[q - 1] > c; --q)
+            {
+                ilu->bi[q] = ilu->bi[q - 1];
+                ilu->map[q] = ilu->map[q - 1];
+            }
+            ilu->bi[q] = c;
+            ilu->map[q] = m;
+        }
+        ilu->diag[k] = -1;
+        for (q = ilu->bp[k]; q < ilu->bp[k + 1]; ++q)
+        {
+            if (ilu->bi[q] == k)
+                ilu->diag[k] = q;
+        }
+        if (ilu->diag[k] < 0)
+            __atomic_store_n(&args->singular, 1, __ATOMIC_RELAXED);
+    }
+}
+
+int _HypamasLevelILUSymbolic(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int n,
+    IN__ const double *ax,
+    IN__ const int *ap,
+    IN__ const int *ai,
+    IN__ int mode,
+    IN__ int threads)
+{
+    _ILUAssembleArgs args;
+    int *rp, *ri, *rmap, *rows;
+    int nnz, k, part[2], retval;
+
+    _HypamasLevelILUFree(ilu);
+    rp = NULL;
+    ri = NULL;
+    rmap = NULL;
+
+    nnz = ap[n];
+    ilu->n = n;
+    ilu->nnz = nnz;
+    ilu->mode = mode;
+    ilu->perm = (int *)_HypamasMalloc(sizeof(int) * n);
+    ilu->map = (int *)_HypamasMalloc(sizeof(int) * nnz);
+    ilu->bp = (int *)_HypamasMalloc(sizeof(int) * (n + 1));
+    ilu->bi = (int *)_HypamasMalloc(sizeof(int) * nnz);
+    ilu->diag = (int *)_HypamasMalloc(sizeof(int) * n);
+    if (NULL == ilu->perm || NULL == ilu->map || NULL == ilu->bp || NULL == ilu->bi || NULL == ilu->diag)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+
+    retval = _ILUCSRView(n, ap, ai, mode, &rp, &ri, &rmap, threads);
+    if (FAIL(retval))
+        goto FINAL;
+    retval = _ILUMatch(n, rp, ri, rmap, ax, ilu->perm);
+    if (FAIL(retval))
+        goto FINAL;
+
+    /*row k of the factors is row perm[k] of A, the rows are independent once their offsets are known*/
+    ilu->bp[0] = 0;
+    for (k = 0; k < n; ++k)
+        ilu->bp[k + 1] = ilu->bp[k] + rp[ilu->perm[k] + 1] - rp[ilu->perm[k]];
+    args.ilu = ilu;
+    args.rp = rp;
+    args.ri = ri;
+    args.rmap = rmap;
+    args.singular = 0;
+    threads = _HYPAMAS_MAX(1, _HYPAMAS_MIN(threads, nnz / _ILU_SYMBOLIC_NNZ_PER_THREAD));
+    if (threads > 1)
+    {
+        rows = (int *)_HypamasMalloc(sizeof(int) * (threads + 1));
+        if (NULL == rows)
+        {
+            retval = kErrorOutOfMemory;
+            goto FINAL;
+        }
+        _HypamasPartitionRows(n, ilu->bp, 1, threads, rows);
+        args.part = rows;
+        retval = _ILUSymbolicRun(_ILUAssembleProc, &args, threads);
+        _HypamasFree(rows);
+        if (FAIL(retval))
+            goto FINAL;
+    }
+    else
+    {
+        part[0] = 0;
+        part[1] = n;
+        args.part = part;
+        _ILUAssembleProc(&args, 0, 1);
+    }
+    if (args.singular)
+    {
+        retval = kErrorMatrixStructuralSingular;
+        goto FINAL;
+    }
+
+    /*a level of fill of n keeps every fill-in, the factors are the complete LU of B*/
+    if (ilu->exact)
+        ilu->fill = _HYPAMAS_MAX(ilu->fill, n);
+    if (ilu->fill > 0)
+    {
+        retval = _ILUFill(ilu, ilu->fill, threads);
+        if (FAIL(retval))
+            goto FINAL;
+    }
+
+    retval = _ILULevels(ilu, 0, threads);
+    if (FAIL(retval))
+        goto FINAL;
+    retval = _ILULevels(ilu, 1, threads);
+    if (FAIL(retval))
+        goto FINAL;
+    retval = _HypamasLevelILUAllocNumeric(ilu);
+
+    /*the CSR view of a CSC input is kept for the SpMV of the GMRES*/
+    if (OK(retval) && 0 != mode)
+    {
+        ilu->rp = rp;
+        ilu->ri = ri;
+        ilu->rmap = rmap;
+        rp = ri = rmap = NULL;
+    }
+
+FINAL:
+
+    _HypamasFree(rp);
+    _HypamasFree(ri);
+    _HypamasFree(rmap);
+    if (FAIL(retval))
+        _HypamasLevelILUFree(ilu);
+
+    return retval;
+}
+
+int _HypamasLevelILUWide(
+    IN__ const _HypamasLevelILU *ilu,
+    IN__ int threads)
+{
+    int levels;
+
+    if (threads <= 1)
+        return 0;
+    levels = _HYPAMAS_MAX(ilu->lnum, ilu->unum);
+    return ilu->n >= (long long)levels * threads * _ILU_LEVEL_WIDTH;
+}
+
+int _HypamasLevelILUGraph(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int threads)
+{
+    int n = ilu->n, k, retval;
+
+    if (NULL != ilu->lsp)
+        return kHypamasOK;
+
+    ilu->lsp = (int *)_HypamasMalloc(sizeof(int) * (n + 1));
+    ilu->lsi = (int *)_HypamasMalloc(sizeof(int) * _HYPAMAS_MAX(1, ilu->bp[n] - n));
+    ilu->ldeg = (int *)_HypamasMalloc(sizeof(int) * n);
+    retval = NULL == ilu->lsp || NULL == ilu->lsi || NULL == ilu->ldeg ? kErrorOutOfMemory : kHypamasOK;
+
+    /*the columns of the strict L, each in ascending rows*/
+    if (!FAIL(retval))
+        retval = _HypamasTranspose(n, ilu->bp, ilu->diag, ilu->bi, NULL, ilu->lsp, ilu->lsi, NULL, NULL, threads);
+    if (FAIL(retval))
+    {
+        _HypamasFree(ilu->lsp);
+        _HypamasFree(ilu->lsi);
+        _HypamasFree(ilu->ldeg);
+        ilu->lsp = NULL;
+        ilu->lsi = NULL;
+        ilu->ldeg = NULL;
+        return retval;
+    }
+    for (k = 0; k < n; ++k)
+        ilu->ldeg[k] = ilu->diag[k] - ilu->bp[k];
+
+    return kHypamasOK;
+}
+
+/*The same as _ILUFactorizeRow on single precision factors, a scalar gather & scatter through pos reading half the bytes of values and storing them in half the memory.*/
+static void _ILUFactorizeRowSingle(_HypamasLevelILU *ilu, int k, int *pos)
+{
+    const int *bp = ilu->bp, *bi = ilu->bi, *diag = ilu->diag;
+    const unsigned short *bd = ilu->bd;
+    float *bx = ilu->bxs;
+    float l, d, guard;
+    int q, r, j, c;
+
+    for (q = bp[k]; q < bp[k + 1]; ++q)
+        pos[bi[q]] = q;
+
+    for (q = bp[k]; q < diag[k]; ++q)
+    {
+        j = bi[q];
+        l = bx[q] / bx[diag[j]];
+        bx[q] = l;
+        if (bd[diag[j]] & _ILU_NEAR_UPPER)
+        {
+            for (r = diag[j] + 1; r < bp[j + 1]; ++r)
+            {
+                c = pos[j + bd[r]];
+                if (c >= 0)
+                    bx[c] -= l * bx[r];
+            }
+        }
+        else
+        {
+            for (r = diag[j] + 1; r < bp[j + 1]; ++r)
+            {
+                c = pos[bi[r]];
+                if (c >= 0)
+                    bx[c] -= l * bx[r];
+            }
+        }
+    }
+
+    d = bx[diag[k]];
+    guard = (float)(_ILU_PIVOT_GUARD * ilu->rowmax[k]);
+    if (fabsf(d) < guard || 0.f == d)
+    {
+        __atomic_fetch_add(&ilu->perturbed, 1, __ATOMIC_RELAXED);
+        bx[diag[k]] = d < 0.f ? -guard : guard;
+        if (0.f == guard)
+            bx[diag[k]] = 1.f;
+    }
+
+    for (q = bp[k]; q < bp[k + 1]; ++q)
+        pos[bi[q]] = -1;
+}
+
+static void _ILUFactorizeRow(_HypamasLevelILU *ilu, int k, int *pos)
+{
+    const int *bp = ilu->bp, *bi = ilu->bi, *diag = ilu->diag;
+    const unsigned short *bd = ilu->bd;
+    double *bx = ilu->bx;
+    double l, d, guard;
+    int q, r, j, c;
+
+    if (NULL != ilu->bxs)
+    {
+        _ILUFactorizeRowSingle(ilu, k, pos);
+        return;
+    }
+
+    for (q = bp[k]; q < bp[k + 1]; ++q)
+        pos[bi[q]] = q;
+
+    for (q = bp[k]; q < diag[k]; ++q)
+    {
+        j = bi[q];
+        l = bx[q] / bx[diag[j]];
+        bx[q] = l;
+        if (bd[diag[j]] & _ILU_NEAR_UPPER)
+        {
+            for (r = diag[j] + 1; r < bp[j + 1]; ++r)
+            {
+                c = pos[j + bd[r]];
+                if (c >= 0)
+                    bx[c] -= l * bx[r];
+            }
+        }
+        else
+        {
+            for (r = diag[j] + 1; r < bp[j + 1]; ++r)
+            {
+                c = pos[bi[r]];
+                if (c >= 0)
+                    bx[c] -= l * bx[r];
+            }
+        }
+    }
+
+    d = bx[diag[k]];
+    guard = _ILU_PIVOT_GUARD * ilu->rowmax[k];
+    if (fabs(d) < guard || 0. == d)
+    {
+        __atomic_fetch_add(&ilu->perturbed, 1, __ATOMIC_RELAXED);
+        bx[diag[k]] = d < 0. ? -guard : guard;
+        if (0. == guard)
+            bx[diag[k]] = 1.;
+    }
+
+    for (q = bp[k]; q < bp[k + 1]; ++q)
+        pos[bi[q]] = -1;
+}
+
+typedef struct
+{
+    _HypamasLevelILU *ilu;
+    _HypamasTeam *team;
+    int wide;
+    int levels;      /* rows[ptr[lev]:ptr[lev+1]] are factorized at level lev */
+    const int *ptr;  /* NULL means all rows in the natural order */
+    const int *rows;
+    _HypamasTaskGraph *graph; /* work stealing over the rows instead of the levels if not NULL */
+} _ILUFactorizeArgs;
+
+static void _ILUFactorizeNode(void *arg, int k, int tid)
+{
+    _HypamasLevelILU *ilu = ((_ILUFactorizeArgs *)arg)->ilu;
+    _ILUFactorizeRow(ilu, k, ilu->pos + (size_t)tid * ilu->n);
+}
+
+static void _ILUFactorizeProc(void *arg, int tid, int threads)
+{
+    _ILUFactorizeArgs *args = (_ILUFactorizeArgs *)arg;
+    _HypamasLevelILU *ilu = args->ilu;
+    int *pos, lev, lo, hi, cnt, i;
+
+    pos = ilu->pos + (size_t)tid * ilu->n;
+
+    if (NULL != args->graph)
+    {
+        _HypamasTaskGraphRun(args->graph, args->team, tid, threads, _ILUFactorizeNode, args);
+        return;
+    }
+
+    if (!args->wide)
+    {
+        if (0 != tid)
+            return;
+        if (NULL == args->ptr)
+        {
+            for (i = 0; i < ilu->n; ++i)
+                _ILUFactorizeRow(ilu, i, pos);
+        }
+        else
+        {
+            for (i = args->ptr[0]; i < args->ptr[args->levels]; ++i)
+                _ILUFactorizeRow(ilu, args->rows[i], pos);
+        }
+        return;
+    }
+
+    for (lev = 0; lev < args->levels; ++lev)
+    {
+        cnt = args->ptr[lev + 1] - args->ptr[lev];
+        lo = args->ptr[lev] + (int)((long long)cnt * tid / threads);
+        hi = args->ptr[lev] + (int)((long long)cnt * (tid + 1) / threads);
+        for (i = lo; i < hi; ++i)
+            _ILUFactorizeRow(ilu, args->rows[i], pos);
+        _HypamasTeamBarrier(args->team, threads);
+    }
+}
+
+double _HypamasLevelILUFlops(
+    INOUT__ _HypamasLevelILU *ilu)
+{
+    int k, q, j;
+
+    /*each entry of L divides once and updates the row by the strict U of its column*/
+    if (0. == ilu->flops)
+    {
+        for (k = 0; k < ilu->n; ++k)
+        {
+            for (q = ilu->bp[k]; q < ilu->diag[k]; ++q)
+            {
+                j = ilu->bi[q];
+                ilu->flops += 1. + 2. * (ilu->bp[j + 1] - ilu->diag[j] - 1);
+            }
+        }
+    }
+
+    return ilu->flops;
+}
+
+int _HypamasLevelILUPos(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int threads)
+{
+    int *pos;
+    size_t k;
+
+    /*every row restores the entries it sets, so only the new part is initialized*/
+    if (threads <= ilu->npos)
+        return kHypamasOK;
+    pos = (int *)_HypamasRealloc(ilu->pos, sizeof(int) * ilu->n * threads);
+    if (NULL == pos)
+        return kErrorOutOfMemory;
+    for (k = (size_t)ilu->n * ilu->npos; k < (size_t)ilu->n * threads; ++k)
+        pos[k] = -1;
+    ilu->pos = pos;
+    ilu->npos = threads;
+
+    return kHypamasOK;
+}
+
+static int _ILUFactorizeRun(_ILUFactorizeArgs *args, int threads)
+{
+    _HypamasTeam *team;
+    int retval;
+
+    retval = _HypamasLevelILUPos(args->ilu, threads);
+    if (FAIL(retval))
+        return retval;
+
+    retval = _HypamasTeamAcquire(&team, threads);
+    if (FAIL(retval))
+        return retval;
+    args->team = team;
+    _HypamasTeamRun(team, threads, _ILUFactorizeProc, args);
+    _HypamasTeamRelease(team);
+
+    return kHypamasOK;
+}
+
+/*Copy the values of row k of B from A.*/
+static void _ILULoadRow(_HypamasLevelILU *ilu, int k, const double *ax)
+{
+    double v;
+    int q;
+
+    ilu->rowmax[k] = 0.;
+    for (q = ilu->bp[k]; q < ilu->bp[k + 1]; ++q)
+    {
+        v = ilu->map[q] >= 0 ? ax[ilu->map[q]] : 0.;
+        if (NULL != ilu->bxs)
+            ilu->bxs[q] = (float)v;
+        else
+            ilu->bx[q] = v;
+        ilu->rowmax[k] = _HYPAMAS_MAX(ilu->rowmax[k], fabs(v));
+    }
+}
+
+int _HypamasLevelILUNumeric(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ const double *ax,
+    IN__ int threads)
+{
+    _ILUFactorizeArgs args;
+    int k, retval, steal;
+
+    args.ilu = ilu;
+    args.wide = _HypamasLevelILUWide(ilu, threads);
+    args.graph = NULL;
+    steal = kCfgILUScheduleSteal == ilu->schedule && threads > 1 && ilu->n >= (long long)threads * _ILU_STEAL_ROWS;
+    if (steal)
+    {
+        args.wide = 0;
+        retval = _HypamasLevelILUGraph(ilu, threads);
+        if (FAIL(retval))
+            return retval;
+        if (NULL != ilu->graph && _HypamasTaskGraphThreads(ilu->graph) < threads)
+        {
+            _HypamasTaskGraphFree(ilu->graph);
+            ilu->graph = NULL;
+        }
+        if (NULL == ilu->graph)
+        {
+            retval = _HypamasTaskGraphCreate(&ilu->graph, ilu->n, ilu->lsp, ilu->lsi, ilu->ldeg, threads);
+            if (FAIL(retval))
+                return retval;
+        }
+        args.graph = ilu->graph;
+    }
+    else if (!args.wide)
+    {
+        threads = 1;
+    }
+    args.levels = ilu->lnum;
+    args.ptr = args.wide ? ilu->lptr : NULL;
+    args.rows = ilu->lrows;
+
+    /*the precision may have changed since the last factorization*/
+    if ((kCfgILUPrecisionSingle == ilu->precision) != (NULL != ilu->bxs))
+    {
+        ilu->factorized = 0;
+        retval = _HypamasLevelILUAllocNumeric(ilu);
+        if (FAIL(retval))
+            return retval;
+    }
+
+    /*an analysis loaded from a file may have been computed with a lower level of fill*/
+    if (ilu->exact && ilu->fill < ilu->n)
+    {
+        ilu->factorized = 0;
+        return kErrorMatrixConsistencyCheck;
+    }
+
+    for (k = 0; k < ilu->n; ++k)
+        _ILULoadRow(ilu, k, ax);
+
+    ilu->perturbed = 0;
+    retval = _ILUFactorizeRun(&args, threads);
+    if (FAIL(retval))
+        return retval;
+    if (ilu->exact && ilu->perturbed > 0)
+    {
+        ilu->factorized = 0;
+        return kErrorMatrixNumericSingular;
+    }
+
+    ilu->factorized = 1;
+    return kHypamasOK;
+}
+
+int _HypamasLevelILUPartialNumeric(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ const double *ax,
+    IN__ const int *changed,
+    IN__ int nchanged,
+    IN__ int threads,
+    OUT__ int *updated)
+{
+    _ILUFactorizeArgs args;
+    char *entry, *row;
+    int *ptr, *rows, k, q, i, lev, cnt, retval;
+    size_t mark;
+
+    /*the precision changed since the last factorization, the kept rows are in the other precision and all rows are refactorized*/
+    if ((kCfgILUPrecisionSingle == ilu->precision) != (NULL != ilu->bxs))
+    {
+        if (NULL != updated)
+            *updated = ilu->n;
+        return _HypamasLevelILUNumeric(ilu, ax, threads);
+    }
+
+    /*the temporaries come from the scratch arena, a repeated refactorization does not allocate*/
+    mark = _HypamasArenaMark();
+    entry = (char *)_HypamasArenaAlloc(sizeof(char) * ilu->nnz);
+    row = (char *)_HypamasArenaAlloc(sizeof(char) * ilu->n);
+    ptr = (int *)_HypamasArenaAlloc(sizeof(int) * (ilu->lnum + 1));
+    rows = (int *)_HypamasArenaAlloc(sizeof(int) * ilu->n);
+    if (NULL == entry || NULL == row || NULL == ptr || NULL == rows)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+    memset(entry, 0, sizeof(char) * ilu->nnz);
+    memset(row, 0, sizeof(char) * ilu->n);
+
+    for (i = 0; i < nchanged; ++i)
+    {
+        if (changed[i] < 0 || changed[i] >= ilu->nnz)
+        {
+            retval = kErrorInvalidArgument;
+            goto FINAL;
+        }
+        entry[changed[i]] = 1;
+    }
+
+    /*row k is refactorized if it holds a changed entry or L(k,j) != 0 for a refactorized row j < k*/
+    cnt = 0;
+    for (k = 0; k < ilu->n; ++k)
+    {
+        for (q = ilu->bp[k]; q < ilu->bp[k + 1] && !row[k]; ++q)
+            row[k] = ilu->map[q] >= 0 && entry[ilu->map[q]];
+        for (q = ilu->bp[k]; q < ilu->diag[k] && !row[k]; ++q)
+            row[k] = row[ilu->bi[q]];
+        if (row[k])
+        {
+            _ILULoadRow(ilu, k, ax);
+            ++cnt;
+        }
+    }
+    if (NULL != updated)
+        *updated = cnt;
+
+    args.ilu = ilu;
+    args.graph = NULL;
+    args.wide = _HypamasLevelILUWide(ilu, threads) && cnt >= (long long)ilu->lnum * threads * _ILU_LEVEL_WIDTH;
+    if (!args.wide)
+        threads = 1;
+    args.levels = args.wide ? ilu->lnum : 1;
+    args.ptr = ptr;
+    args.rows = rows;
+
+    /*the affected rows keep the order of the level sets, or the natural order if run sequentially*/
+    cnt = 0;
+    ptr[0] = 0;
+    if (args.wide)
+    {
+        for (lev = 0; lev < ilu->lnum; ++lev)
+        {
+            for (i = ilu->lptr[lev]; i < ilu->lptr[lev + 1]; ++i)
+            {
+                if (row[ilu->lrows[i]])
+                    rows[cnt++] = ilu->lrows[i];
+            }
+            ptr[lev + 1] = cnt;
+        }
+    }
+    else
+    {
+        for (k = 0; k < ilu->n; ++k)
+        {
+            if (row[k])
+                rows[cnt++] = k;
+        }
+        ptr[1] = cnt;
+    }
+
+    ilu->perturbed = 0;
+    retval = cnt > 0 ? _ILUFactorizeRun(&args, threads) : kHypamasOK;
+    /*the kept rows were not perturbed, the last factorization of an exact preconditioner succeeded*/
+    if (OK(retval) && ilu->exact && ilu->perturbed > 0)
+    {
+        ilu->factorized = 0;
+        retval = kErrorMatrixNumericSingular;
+    }
+
+FINAL:
+
+    _HypamasArenaReset(mark);
+
+    return retval;
+}
+
+/*Single precision factors are read as float and accumulated in double.*/
+/*Rows whose columns are all near the diagonal read them as 16-bit distances, halving the index traffic.*/
+static void _ILUForwardRow(const _HypamasLevelILU *ilu, int k, const double *in, double *out)
+{
+    const unsigned short *bd = ilu->bd;
+    const int *bi = ilu->bi;
+    const double *xk = out + k;
+    const int lo = ilu->bp[k], hi = ilu->diag[k];
+    double s;
+    int q;
+
+    s = in[ilu->perm[k]];
+    if (NULL != ilu->bxs)
+    {
+        if (bd[hi] & _ILU_NEAR_LOWER)
+        {
+            for (q = lo; q < hi; ++q)
+                s -= (double)ilu->bxs[q] * xk[-(int)bd[q]];
+        }
+        else
+        {
+            for (q = lo; q < hi; ++q)
+                s -= (double)ilu->bxs[q] * out[bi[q]];
+        }
+    }
+    else if (bd[hi] & _ILU_NEAR_LOWER)
+    {
+        for (q = lo; q < hi; ++q)
+            s -= ilu->bx[q] * xk[-(int)bd[q]];
+    }
+    else
+    {
+        for (q = lo; q < hi; ++q)
+            s -= ilu->bx[q] * out[bi[q]];
+    }
+    out[k] = s;
+}
+
+static void _ILUBackwardRow(const _HypamasLevelILU *ilu, int k, double *out)
+{
+    const unsigned short *bd = ilu->bd;
+    const int *bi = ilu->bi;
+    const double *xk = out + k;
+    const int d = ilu->diag[k], hi = ilu->bp[k + 1];
+    double s;
+    int q;
+
+    s = out[k];
+    if (NULL != ilu->bxs)
+    {
+        if (bd[d] & _ILU_NEAR_UPPER)
+        {
+            for (q = d + 1; q < hi; ++q)
+                s -= (double)ilu->bxs[q] * xk[bd[q]];
+        }
+        else
+        {
+            for (q = d + 1; q < hi; ++q)
+                s -= (double)ilu->bxs[q] * out[bi[q]];
+        }
+        out[k] = s / (double)ilu->bxs[d];
+        return;
+    }
+    if (bd[d] & _ILU_NEAR_UPPER)
+    {
+        for (q = d + 1; q < hi; ++q)
+            s -= ilu->bx[q] * xk[bd[q]];
+    }
+    else
+    {
+        for (q = d + 1; q < hi; ++q)
+            s -= ilu->bx[q] * out[bi[q]];
+    }
+    out[k] = s / ilu->bx[d];
+}
+
+int _HypamasLevelILUApply(
+    IN__ void *data,
+    IN__ const double *in,
+    OUT__ double *out,
+    IN__ _HypamasTeam *team,
+    IN__ int tid,
+    IN__ int threads)
+{
+    const _HypamasLevelILU *ilu = (const _HypamasLevelILU *)data;
+    int lev, lo, hi, cnt, i, k;
+    long long start;
+
+    _HypamasTeamBarrier(team, threads);
+    start = 0 == tid ? _HypamasTraceClock() : 0;
+
+    if (!_HypamasLevelILUWide(ilu, threads))
+    {
+        if (0 == tid)
+        {
+            for (k = 0; k < ilu->n; ++k)
+                _ILUForwardRow(ilu, k, in, out);
+            for (k = ilu->n - 1; k >= 0; --k)
+                _ILUBackwardRow(ilu, k, out);
+        }
+        _HypamasTeamBarrier(team, threads);
+        _HypamasTraceRecord(kTracePhaseILUSolve, start, 2. * ilu->bp[ilu->n]);
+        return kHypamasOK;
+    }
+
+    for (lev = 0; lev < ilu->lnum; ++lev)
+    {
+        cnt = ilu->lptr[lev + 1] - ilu->lptr[lev];
+        lo = ilu->lptr[lev] + (int)((long long)cnt * tid / threads);
+        hi = ilu->lptr[lev] + (int)((long long)cnt * (tid + 1) / threads);
+        for (i = lo; i < hi; ++i)
+            _ILUForwardRow(ilu, ilu->lrows[i], in, out);
+        _HypamasTeamBarrier(team, threads);
+    }
+    for (lev = 0; lev < ilu->unum; ++lev)
+    {
+        cnt = ilu->uptr[lev + 1] - ilu->uptr[lev];
+        lo = ilu->uptr[lev] + (int)((long long)cnt * tid / threads);
+        hi = ilu->uptr[lev] + (int)((long long)cnt * (tid + 1) / threads);
+        for (i = lo; i < hi; ++i)
+            _ILUBackwardRow(ilu, ilu->urows[i], out);
+        _HypamasTeamBarrier(team, threads);
+    }
+    _HypamasTraceRecord(kTracePhaseILUSolve, start, 2. * ilu->bp[ilu->n]);
+
+    return kHypamasOK;
+}
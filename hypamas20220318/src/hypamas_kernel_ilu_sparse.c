@@ -0,0 +1,232 @@
+/*used to apply the level ILU(k) to a sparse right hand side for selected entries of the result*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "hypamas_ext_internal.h"
+
+/**
+ * @brief Workspace of the sparse solve, built at the first call and kept until the analysis changes.
+ * The reach of the last pattern of the right hand side and of the output are cached.
+ */
+typedef struct
+{
+    int *iperm; /* row i of A is row iperm[i] of B */
+    char *mark; /* n, all zero between calls */
+    int *stack; /* n */
+    int *next;  /* n, next edge of the nodes on the stack */
+    double *y;  /* n, all zero between calls */
+    double *x;  /* n */
+
+    int *rkey; /* last pattern of the right hand side */
+    int rnum;
+    int rcap;
+    int *rreach; /* forward reach of rkey, ascending */
+    int rcnt;
+
+    int *okey; /* last requested outputs */
+    int onum;
+    int ocap;
+    int *oreach; /* backward reach of okey, ascending */
+    int ocnt;
+} _ILUSparse;
+
+void _HypamasLevelILUSparseFree(
+    INOUT__ void *sparse)
+{
+    _ILUSparse *s = (_ILUSparse *)sparse;
+
+    if (NULL == s)
+        return;
+    _HypamasFree(s->iperm);
+    _HypamasFree(s->mark);
+    _HypamasFree(s->stack);
+    _HypamasFree(s->next);
+    _HypamasFree(s->y);
+    _HypamasFree(s->x);
+    _HypamasFree(s->rkey);
+    _HypamasFree(s->rreach);
+    _HypamasFree(s->okey);
+    _HypamasFree(s->oreach);
+    _HypamasFree(s);
+}
+
+static _ILUSparse *_SparseCreate(_HypamasLevelILU *ilu)
+{
+    _ILUSparse *s;
+    int n = ilu->n, k;
+
+    /*the forward reach walks the columns of L*/
+    if (FAIL(_HypamasLevelILUGraph(ilu, 1)))
+        return NULL;
+    s = (_ILUSparse *)_HypamasCalloc(1, sizeof(_ILUSparse));
+    if (NULL == s)
+        return NULL;
+    s->iperm = (int *)_HypamasMalloc(sizeof(int) * n);
+    s->mark = (char *)_HypamasCalloc(n, sizeof(char));
+    s->stack = (int *)_HypamasMalloc(sizeof(int) * n);
+    s->next = (int *)_HypamasMalloc(sizeof(int) * n);
+    s->y = (double *)_HypamasCalloc(n, sizeof(double));
+    s->x = (double *)_HypamasMalloc(sizeof(double) * n);
+    s->rreach = (int *)_HypamasMalloc(sizeof(int) * n);
+    s->oreach = (int *)_HypamasMalloc(sizeof(int) * n);
+    if (NULL == s->iperm || NULL == s->mark || NULL == s->stack ||
+        NULL == s->next || NULL == s->y || NULL == s->x || NULL == s->rreach || NULL == s->oreach)
+    {
+        _HypamasLevelILUSparseFree(s);
+        return NULL;
+    }
+
+    for (k = 0; k < n; ++k)
+        s->iperm[ilu->perm[k]] = k;
+    s->rnum = -1;
+    s->onum = -1;
+
+    return s;
+}
+
+/*Nodes reachable from map[src] in postorder, the same depth-first search as Gilbert-Peierls.*/
+/*The edges of node k are gi[begin[k]+skip : end[k]], map NULL means the identity.*/
+static int _SparseReach(_ILUSparse *s, const int *begin, const int *end, int skip, const int *gi,
+                        const int *src, int nsrc, const int *map, int *list)
+{
+    int cnt, top, i, j, k;
+
+    cnt = 0;
+    for (i = 0; i < nsrc; ++i)
+    {
+        k = NULL == map ? src[i] : map[src[i]];
+        if (s->mark[k])
+            continue;
+        top = 0;
+        s->stack[0] = k;
+        s->next[k] = begin[k] + skip;
+        s->mark[k] = 1;
+        while (top >= 0)
+        {
+            k = s->stack[top];
+            if (s->next[k] < end[k])
+            {
+                j = gi[s->next[k]++];
+                if (!s->mark[j])
+                {
+                    s->mark[j] = 1;
+                    s->next[j] = begin[j] + skip;
+                    s->stack[++top] = j;
+                }
+            }
+            else
+            {
+                list[cnt++] = k;
+                --top;
+            }
+        }
+    }
+    for (i = 0; i < cnt; ++i)
+        s->mark[list[i]] = 0;
+
+    return cnt;
+}
+
+static int _SparseCompare(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+/*Copy key to the cache, return non-zero if it is the same as the cached one.*/
+static int _SparseKey(int **cache, int *num, int *cap, const int *key, int cnt, int *retval)
+{
+    int *p;
+
+    if (cnt == *num && 0 == memcmp(*cache, key, sizeof(int) * cnt))
+        return 1;
+    if (cnt > *cap)
+    {
+        p = (int *)_HypamasRealloc(*cache, sizeof(int) * cnt);
+        if (NULL == p)
+        {
+            *retval = kErrorOutOfMemory;
+            return 0;
+        }
+        *cache = p;
+        *cap = cnt;
+    }
+    memcpy(*cache, key, sizeof(int) * cnt);
+    *num = cnt;
+    return 0;
+}
+
+int _HypamasLevelILUSparseSolve(
+    INOUT__ _HypamasLevelILU *ilu,
+    IN__ int nz,
+    IN__ const int *idx,
+    IN__ const double *val,
+    IN__ int nout,
+    IN__ const int *out,
+    OUT__ double *sol,
+    OUT__ int *reach)
+{
+    _ILUSparse *s;
+    const int *bp = ilu->bp, *bi = ilu->bi, *diag = ilu->diag;
+    int i, k, q, retval;
+    double v;
+
+    if (NULL == ilu->sparse)
+    {
+        ilu->sparse = _SparseCreate(ilu);
+        if (NULL == ilu->sparse)
+            return kErrorOutOfMemory;
+    }
+    s = (_ILUSparse *)ilu->sparse;
+
+    /*forward reach of the right hand side through the columns of L, backward reach of the outputs through the rows of U*/
+    retval = kHypamasOK;
+    if (!_SparseKey(&s->rkey, &s->rnum, &s->rcap, idx, nz, &retval))
+    {
+        if (FAIL(retval))
+            return retval;
+        s->rcnt = _SparseReach(s, ilu->lsp, ilu->lsp + 1, 0, ilu->lsi, idx, nz, s->iperm, s->rreach);
+        qsort(s->rreach, s->rcnt, sizeof(int), _SparseCompare);
+    }
+    if (!_SparseKey(&s->okey, &s->onum, &s->ocap, out, nout, &retval))
+    {
+        if (FAIL(retval))
+            return retval;
+        s->ocnt = _SparseReach(s, diag, bp + 1, 1, bi, out, nout, NULL, s->oreach);
+        qsort(s->oreach, s->ocnt, sizeof(int), _SparseCompare);
+    }
+
+    for (i = 0; i < nz; ++i)
+        s->y[s->iperm[idx[i]]] += val[i];
+    /*rows in ascending order are a topological order of L and descending of U, and keep the access local*/
+    for (i = 0; i < s->rcnt; ++i)
+    {
+        k = s->rreach[i];
+        v = s->y[k];
+        for (q = bp[k]; q < diag[k]; ++q)
+            v -= _HypamasLevelILUValue(ilu, q) * s->y[bi[q]];
+        s->y[k] = v;
+    }
+
+    for (i = s->ocnt - 1; i >= 0; --i)
+    {
+        k = s->oreach[i];
+        v = s->y[k];
+        for (q = diag[k] + 1; q < bp[k + 1]; ++q)
+            v -= _HypamasLevelILUValue(ilu, q) * s->x[bi[q]];
+        s->x[k] = v / _HypamasLevelILUValue(ilu, diag[k]);
+    }
+    for (i = 0; i < nout; ++i)
+        sol[i] = s->x[out[i]];
+
+    for (i = 0; i < s->rcnt; ++i)
+        s->y[s->rreach[i]] = 0.;
+    if (NULL != reach)
+    {
+        reach[0] = s->rcnt;
+        reach[1] = s->ocnt;
+    }
+
+    return kHypamasOK;
+}
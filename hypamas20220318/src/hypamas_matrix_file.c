@@ -0,0 +1,737 @@
+/*used to read matrix market files in parallel and read & write the binary matrix files*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hypamas_ext_internal.h"
+
+#define _MATRIX_FILE_MAGIC "HYPACSR"
+#define _MATRIX_FILE_VERSION 1
+#define _MATRIX_FILE_SORT_SHORT 32 /* rows not longer than it are sorted by insertion */
+
+enum
+{
+    _kSymmetryGeneral = 0,
+    _kSymmetrySymmetric,
+    _kSymmetrySkew,
+};
+
+/**
+ * @brief Shared state of the parallel matrix market parser
+ */
+typedef struct
+{
+    const char *begin; /* first line of the entries */
+    const char *end;
+    int n;
+    int vector;   /* parse a dense vector, no ap & ai */
+    int array;    /* array format, otherwise coordinate */
+    int pattern;  /* no values, all ones */
+    int symmetry; /* _kSymmetryXxx */
+    int mode;     /* 0: compressed by the column index of the file, otherwise by the row index */
+    long long entries;
+    _HypamasTeam *team;
+
+    const char **chunk; /* threads+1 chunk boundaries */
+    long long *offset;  /* threads+1 entry offsets of the chunks */
+    long long *moffset; /* threads+1 offsets of the mirrored entries */
+    int *row;           /* coordinate entries, 0-based, room for the mirrors */
+    int *col;
+    double *val;
+    long long total; /* entries including mirrors */
+    int *cnt;        /* n+1 row pointers of the unmerged entries */
+    int *pos;        /* n scatter positions */
+    int *idx;        /* unsorted compressed indices */
+    double *x;       /* unsorted compressed values */
+    int *part;       /* threads+1 row partition */
+    int *ap;         /* [OUT] */
+    int *ai;         /* [OUT] */
+    double *ax;      /* [OUT] */
+    int *error;      /* error code of each thread */
+} _HypamasMMParser;
+
+/**
+ * @brief Header of the binary matrix file, followed by ap, ai & ax at 8-byte aligned offsets.
+ * Native byte order, the file is only valid on the same architecture.
+ */
+typedef struct
+{
+    char magic[8];
+    int version;
+    int header; /* size of the header in bytes */
+    int n;
+    int nnz;
+    int mode; /* 0 for CSR, otherwise CSC */
+    int reserved;
+    long long offset[3]; /* ap, ai, ax */
+} _HypamasMatrixFileHeader;
+
+/*a line of the data section, returns the next line, *line is NULL for empty & comment lines*/
+static const char *_MMNextLine(const char *p, const char *end, const char **line)
+{
+    const char *s;
+
+    while (p < end && (' ' == *p || '\t' == *p || '\r' == *p))
+        ++p;
+    s = p;
+    while (p < end && '\n' != *p)
+        ++p;
+    *line = (s < p && '%' != *s && '\r' != *s) ? s : NULL;
+
+    return p < end ? p + 1 : end;
+}
+
+static const char *_MMParseInt(const char *p, const char *end, long long *v)
+{
+    long long x;
+    int neg;
+
+    while (p < end && (' ' == *p || '\t' == *p))
+        ++p;
+    neg = 0;
+    if (p < end && ('-' == *p || '+' == *p))
+        neg = '-' == *p++;
+    if (p >= end || !isdigit((unsigned char)*p))
+        return NULL;
+    x = 0;
+    while (p < end && isdigit((unsigned char)*p))
+        x = x * 10 + (*p++ - '0');
+    *v = neg ? -x : x;
+
+    return p;
+}
+
+static const char *_MMParseDouble(const char *p, const char *end, double *v)
+{
+    char buf[64], *stop;
+    int k;
+
+    while (p < end && (' ' == *p || '\t' == *p))
+        ++p;
+    for (k = 0; p + k < end && k < 63 && !isspace((unsigned char)p[k]); ++k)
+        buf[k] = p[k];
+    buf[k] = '\0';
+    if (0 == k)
+        return NULL;
+    *v = strtod(buf, &stop);
+    if (stop != buf + k)
+        return NULL;
+
+    return p + k;
+}
+
+static void _MMSift(int *idx, double *x, int i, int size)
+{
+    int j, t;
+    double v;
+
+    while ((j = 2 * i + 1) < size)
+    {
+        if (j + 1 < size && idx[j + 1] > idx[j])
+            ++j;
+        if (idx[i] >= idx[j])
+            break;
+        t = idx[i], idx[i] = idx[j], idx[j] = t;
+        v = x[i], x[i] = x[j], x[j] = v;
+        i = j;
+    }
+}
+
+/*sort a row by index and sum the duplicates, returns the merged length*/
+static int _MMSortRow(int *idx, double *x, int len)
+{
+    int i, j, k, t;
+    double v;
+
+    if (len <= _MATRIX_FILE_SORT_SHORT)
+    {
+        for (i = 1; i < len; ++i)
+        {
+            t = idx[i];
+            v = x[i];
+            for (j = i; j > 0 && idx[j - 1] > t; --j)
+            {
+                idx[j] = idx[j - 1];
+                x[j] = x[j - 1];
+            }
+            idx[j] = t;
+            x[j] = v;
+        }
+    }
+    else
+    {
+        /*heap sort, long rows are rare in circuit matrices*/
+        for (i = len / 2 - 1; i >= 0; --i)
+            _MMSift(idx, x, i, len);
+        for (i = len - 1; i > 0; --i)
+        {
+            t = idx[0], idx[0] = idx[i], idx[i] = t;
+            v = x[0], x[0] = x[i], x[i] = v;
+            _MMSift(idx, x, 0, i);
+        }
+    }
+
+    k = 0;
+    for (i = 0; i < len; ++i)
+    {
+        if (k > 0 && idx[k - 1] == idx[i])
+        {
+            x[k - 1] += x[i];
+        }
+        else
+        {
+            idx[k] = idx[i];
+            x[k] = x[i];
+            ++k;
+        }
+    }
+    return k;
+}
+
+/*the same error on all threads after the barrier*/
+static int _MMCheck(_HypamasMMParser *ps, int threads)
+{
+    int t;
+
+    _HypamasTeamBarrier(ps->team, threads);
+    for (t = 0; t < threads; ++t)
+    {
+        if (FAIL(ps->error[t]))
+            return ps->error[t];
+    }
+    return kHypamasOK;
+}
+
+static void _MMParseProc(void *arg, int tid, int threads)
+{
+    _HypamasMMParser *ps = (_HypamasMMParser *)arg;
+    const char *p, *line, *end;
+    long long k, e, r, c, lo, hi;
+    double v;
+    int i, key, q;
+
+    /*1. entries of each chunk*/
+    end = ps->chunk[tid + 1];
+    k = 0;
+    for (p = ps->chunk[tid]; p < end;)
+    {
+        p = _MMNextLine(p, end, &line);
+        if (NULL != line)
+            ++k;
+    }
+    ps->offset[tid + 1] = k;
+    _HypamasTeamBarrier(ps->team, threads);
+    if (0 == tid)
+    {
+        ps->offset[0] = 0;
+        for (i = 0; i < threads; ++i)
+            ps->offset[i + 1] += ps->offset[i];
+        if (ps->offset[threads] != ps->entries)
+            ps->error[0] = kErrorMatrixConsistencyCheck;
+    }
+    if (FAIL(_MMCheck(ps, threads)))
+        return;
+
+    /*2. parse the chunk into coordinate entries*/
+    e = ps->offset[tid];
+    for (p = ps->chunk[tid]; p < end;)
+    {
+        p = _MMNextLine(p, end, &line);
+        if (NULL == line)
+            continue;
+
+        r = ps->vector ? e : e % ps->n;
+        c = ps->vector ? 0 : e / ps->n;
+        v = 1.;
+        if (!ps->array)
+        {
+            line = _MMParseInt(line, p, &r);
+            if (NULL != line)
+                line = _MMParseInt(line, p, &c);
+            if (NULL == line || r < 1 || r > ps->n || c < 1 || (!ps->vector && c > ps->n))
+            {
+                ps->error[tid] = kErrorMatrixConsistencyCheck;
+                break;
+            }
+            --r;
+            --c;
+        }
+        if (!ps->pattern && NULL == _MMParseDouble(line, p, &v))
+        {
+            ps->error[tid] = kErrorMatrixConsistencyCheck;
+            break;
+        }
+        ps->row[e] = (int)r;
+        ps->col[e] = (int)c;
+        ps->val[e] = v;
+        ++e;
+    }
+    if (FAIL(_MMCheck(ps, threads)) || ps->vector)
+        return;
+
+    /*3. mirrors of the symmetric entries are appended*/
+    if (_kSymmetryGeneral != ps->symmetry)
+    {
+        k = 0;
+        for (e = ps->offset[tid]; e < ps->offset[tid + 1]; ++e)
+            k += ps->row[e] != ps->col[e];
+        ps->moffset[tid + 1] = k;
+        _HypamasTeamBarrier(ps->team, threads);
+        if (0 == tid)
+        {
+            ps->moffset[0] = ps->entries;
+            for (i = 0; i < threads; ++i)
+                ps->moffset[i + 1] += ps->moffset[i];
+            ps->total = ps->moffset[threads];
+        }
+        _HypamasTeamBarrier(ps->team, threads);
+        k = ps->moffset[tid];
+        for (e = ps->offset[tid]; e < ps->offset[tid + 1]; ++e)
+        {
+            if (ps->row[e] != ps->col[e])
+            {
+                ps->row[k] = ps->col[e];
+                ps->col[k] = ps->row[e];
+                ps->val[k] = _kSymmetrySkew == ps->symmetry ? -ps->val[e] : ps->val[e];
+                ++k;
+            }
+        }
+        /*step 4 reads the mirrors written by the other threads*/
+        _HypamasTeamBarrier(ps->team, threads);
+    }
+
+    /*4. counts & scatter, compressed by the column index of the file for mode 0 like Hypamas_ReadMatrixMarketFile*/
+    lo = ps->total * tid / threads;
+    hi = ps->total * (tid + 1) / threads;
+    for (e = lo; e < hi; ++e)
+    {
+        key = ps->mode ? ps->row[e] : ps->col[e];
+        __atomic_fetch_add(&ps->cnt[key + 1], 1, __ATOMIC_RELAXED);
+    }
+    _HypamasTeamBarrier(ps->team, threads);
+    if (0 == tid)
+    {
+        for (i = 0; i < ps->n; ++i)
+        {
+            ps->cnt[i + 1] += ps->cnt[i];
+            ps->pos[i] = ps->cnt[i];
+        }
+    }
+    _HypamasTeamBarrier(ps->team, threads);
+    for (e = lo; e < hi; ++e)
+    {
+        key = ps->mode ? ps->row[e] : ps->col[e];
+        q = __atomic_fetch_add(&ps->pos[key], 1, __ATOMIC_RELAXED);
+        ps->idx[q] = ps->mode ? ps->col[e] : ps->row[e];
+        ps->x[q] = ps->val[e];
+    }
+    _HypamasTeamBarrier(ps->team, threads);
+
+    /*5. sort & merge the duplicates, the scatter order does not matter*/
+    if (0 == tid)
+        _HypamasPartitionRows(ps->n, ps->cnt, 1, threads, ps->part);
+    _HypamasTeamBarrier(ps->team, threads);
+    for (i = ps->part[tid]; i < ps->part[tid + 1]; ++i)
+        ps->pos[i] = _MMSortRow(ps->idx + ps->cnt[i], ps->x + ps->cnt[i], ps->cnt[i + 1] - ps->cnt[i]);
+    _HypamasTeamBarrier(ps->team, threads);
+    if (0 == tid)
+    {
+        ps->ap[0] = 0;
+        for (i = 0; i < ps->n; ++i)
+            ps->ap[i + 1] = ps->ap[i] + ps->pos[i];
+        ps->ai = (int *)malloc(sizeof(int) * (ps->ap[ps->n] + 1));
+        ps->ax = (double *)malloc(sizeof(double) * (ps->ap[ps->n] + 1));
+        if (NULL == ps->ai || NULL == ps->ax)
+            ps->error[0] = kErrorOutOfMemory;
+    }
+    if (FAIL(_MMCheck(ps, threads)))
+        return;
+
+    /*6. compact*/
+    for (i = ps->part[tid]; i < ps->part[tid + 1]; ++i)
+    {
+        memcpy(ps->ai + ps->ap[i], ps->idx + ps->cnt[i], sizeof(int) * ps->pos[i]);
+        memcpy(ps->ax + ps->ap[i], ps->x + ps->cnt[i], sizeof(double) * ps->pos[i]);
+    }
+}
+
+/*banner & size line, p is advanced to the first entry*/
+static int _MMParseHeader(const char **p, const char *end, _HypamasMMParser *ps, long long *rows, long long *cols)
+{
+    char banner[5][32];
+    const char *line, *s;
+    long long v[3];
+    int i, k, num;
+
+    /*%%MatrixMarket matrix coordinate real general*/
+    s = *p;
+    for (i = 0; i < 5; ++i)
+    {
+        while (s < end && (' ' == *s || '\t' == *s))
+            ++s;
+        for (k = 0; s < end && k < 31 && !isspace((unsigned char)*s); ++k, ++s)
+            banner[i][k] = (char)tolower((unsigned char)*s);
+        banner[i][k] = '\0';
+    }
+    if (0 != strcmp(banner[0], "%%matrixmarket") || 0 != strcmp(banner[1], "matrix"))
+        return kErrorOpenFileFail;
+    ps->array = 0 == strcmp(banner[2], "array");
+    if (!ps->array && 0 != strcmp(banner[2], "coordinate"))
+        return kErrorOpenFileFail;
+    ps->pattern = 0 == strcmp(banner[3], "pattern");
+    if (!ps->pattern && 0 != strcmp(banner[3], "real") && 0 != strcmp(banner[3], "integer"))
+        return kErrorOpenFileFail;
+    if (0 == strcmp(banner[4], "general"))
+        ps->symmetry = _kSymmetryGeneral;
+    else if (0 == strcmp(banner[4], "symmetric"))
+        ps->symmetry = _kSymmetrySymmetric;
+    else if (0 == strcmp(banner[4], "skew-symmetric"))
+        ps->symmetry = _kSymmetrySkew;
+    else
+        return kErrorOpenFileFail;
+    if (ps->array && _kSymmetryGeneral != ps->symmetry)
+        return kErrorOpenFileFail;
+
+    /*size line after the comments*/
+    s = *p;
+    line = NULL;
+    while (s < end && NULL == line)
+        s = _MMNextLine(s, end, &line);
+    if (NULL == line)
+        return kErrorOpenFileFail;
+    num = ps->array ? 2 : 3;
+    for (i = 0; i < num; ++i)
+    {
+        line = _MMParseInt(line, end, &v[i]);
+        if (NULL == line || v[i] < 0)
+            return kErrorOpenFileFail;
+    }
+    *rows = v[0];
+    *cols = v[1];
+    ps->entries = ps->array ? v[0] * v[1] : v[2];
+    *p = s;
+
+    return kHypamasOK;
+}
+
+int Hypamas_ReadMatrixMarketFileParallel(
+    IN__ char *file,
+    OUT__ int *n,
+    OUT__ int *nnz,
+    OUT__ double **ax,
+    OUT__ int **ap,
+    OUT__ int **ai,
+    IN__ int mode,
+    IN__ int threads)
+{
+    _HypamasMMParser ps;
+    _HypamasTeam *team;
+    struct stat st;
+    const char *base, *p;
+    long long rows, cols, room, e;
+    int fd, t, retval;
+
+    if (NULL == file || NULL == n || NULL == nnz || NULL == ax || (NULL == ap) != (NULL == ai))
+        return kErrorInvalidArgument;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return kErrorOpenFileFail;
+    if (0 != fstat(fd, &st) || 0 == st.st_size)
+    {
+        close(fd);
+        return kErrorOpenFileFail;
+    }
+    base = (const char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == (void *)base)
+        return kErrorOpenFileFail;
+    madvise((void *)base, st.st_size, MADV_SEQUENTIAL);
+
+    memset(&ps, 0, sizeof(ps));
+    ps.end = base + st.st_size;
+    ps.vector = NULL == ap;
+    ps.mode = 0 != mode;
+    p = base;
+    retval = _MMParseHeader(&p, ps.end, &ps, &rows, &cols);
+    if (FAIL(retval))
+        goto FINAL;
+    if ((!ps.vector && rows != cols) || rows > 0x7fffffff || ps.entries > 0x7fffffff)
+    {
+        retval = kErrorMatrixConsistencyCheck;
+        goto FINAL;
+    }
+    ps.begin = p;
+    ps.n = (int)rows;
+    ps.total = ps.entries;
+
+    if (threads <= 0)
+        threads = 1;
+    threads = (int)_HYPAMAS_MAX(1, _HYPAMAS_MIN(threads, (ps.end - ps.begin) / 65536));
+
+    room = _kSymmetryGeneral == ps.symmetry ? ps.entries : 2 * ps.entries;
+    ps.chunk = (const char **)_HypamasMalloc(sizeof(char *) * (threads + 1));
+    ps.offset = (long long *)_HypamasMalloc(sizeof(long long) * (threads + 1));
+    ps.moffset = (long long *)_HypamasMalloc(sizeof(long long) * (threads + 1));
+    ps.error = (int *)_HypamasCalloc(threads, sizeof(int));
+    ps.part = (int *)_HypamasMalloc(sizeof(int) * (threads + 1));
+    ps.row = (int *)_HypamasMalloc(sizeof(int) * (room + 1));
+    ps.col = (int *)_HypamasMalloc(sizeof(int) * (room + 1));
+    ps.val = (double *)_HypamasMalloc(sizeof(double) * (room + 1));
+    if (NULL == ps.chunk || NULL == ps.offset || NULL == ps.moffset || NULL == ps.error || NULL == ps.part ||
+        NULL == ps.row || NULL == ps.col || NULL == ps.val)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+    if (!ps.vector)
+    {
+        if (room > 0x7fffffff)
+        {
+            retval = kErrorMatrixConsistencyCheck;
+            goto FINAL;
+        }
+        ps.cnt = (int *)_HypamasCalloc(ps.n + 1, sizeof(int));
+        ps.pos = (int *)_HypamasMalloc(sizeof(int) * (ps.n + 1));
+        ps.idx = (int *)_HypamasMalloc(sizeof(int) * (room + 1));
+        ps.x = (double *)_HypamasMalloc(sizeof(double) * (room + 1));
+        ps.ap = (int *)malloc(sizeof(int) * (ps.n + 1)); /* returned to the caller like ai & ax */
+        if (NULL == ps.cnt || NULL == ps.pos || NULL == ps.idx || NULL == ps.x || NULL == ps.ap)
+        {
+            retval = kErrorOutOfMemory;
+            goto FINAL;
+        }
+    }
+
+    /*chunks start at the line after the split point*/
+    ps.chunk[0] = ps.begin;
+    for (t = 1; t < threads; ++t)
+    {
+        p = ps.begin + (ps.end - ps.begin) * t / threads;
+        while (p < ps.end && '\n' != p[-1])
+            ++p;
+        ps.chunk[t] = _HYPAMAS_MAX(p, ps.chunk[t - 1]);
+    }
+    ps.chunk[threads] = ps.end;
+
+    retval = _HypamasTeamAcquire(&team, threads);
+    if (FAIL(retval))
+        goto FINAL;
+    ps.team = team;
+    _HypamasTeamRun(team, threads, _MMParseProc, &ps);
+    _HypamasTeamRelease(team);
+    for (t = 0; t < threads && kHypamasOK == retval; ++t)
+        retval = ps.error[t];
+    if (FAIL(retval))
+        goto FINAL;
+
+    if (ps.vector)
+    {
+        /*dense vector, coordinate entries are summed*/
+        *ax = (double *)calloc(ps.array ? ps.entries + 1 : ps.n + 1, sizeof(double));
+        if (NULL == *ax)
+        {
+            retval = kErrorOutOfMemory;
+            goto FINAL;
+        }
+        for (e = 0; e < ps.entries; ++e)
+        {
+            if (ps.array)
+                (*ax)[e] = ps.val[e];
+            else
+                (*ax)[ps.row[e]] += ps.val[e];
+        }
+        *n = ps.n;
+        *nnz = ps.array ? (int)ps.entries : ps.n;
+    }
+    else
+    {
+        *n = ps.n;
+        *nnz = ps.ap[ps.n];
+        *ap = ps.ap;
+        *ai = ps.ai;
+        *ax = ps.ax;
+        ps.ap = NULL;
+        ps.ai = NULL;
+        ps.ax = NULL;
+    }
+
+FINAL:
+
+    munmap((void *)base, st.st_size);
+    _HypamasFree(ps.chunk);
+    _HypamasFree(ps.offset);
+    _HypamasFree(ps.moffset);
+    _HypamasFree(ps.error);
+    _HypamasFree(ps.part);
+    _HypamasFree(ps.row);
+    _HypamasFree(ps.col);
+    _HypamasFree(ps.val);
+    _HypamasFree(ps.cnt);
+    _HypamasFree(ps.pos);
+    _HypamasFree(ps.idx);
+    _HypamasFree(ps.x);
+    free(ps.ap);
+    free(ps.ai);
+    free(ps.ax);
+
+    return retval;
+}
+
+static void _MatrixFileLayout(_HypamasMatrixFileHeader *head)
+{
+    head->offset[0] = sizeof(_HypamasMatrixFileHeader);
+    head->offset[1] = head->offset[0] + ((long long)(head->n + 1) * sizeof(int) + 7) / 8 * 8;
+    head->offset[2] = head->offset[1] + ((long long)head->nnz * sizeof(int) + 7) / 8 * 8;
+}
+
+int Hypamas_WriteBinaryMatrixFile(
+    IN__ char *file,
+    IN__ int n,
+    IN__ int nnz,
+    IN__ double *ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ int mode)
+{
+    _HypamasMatrixFileHeader head;
+    static const char zero[8] = {0};
+    FILE *fp;
+    int *rp, retval, i;
+
+    if (NULL == file || NULL == ax || NULL == ap || NULL == ai || n <= 0 || nnz != ap[n] - ap[0])
+        return kErrorInvalidArgument;
+
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, _MATRIX_FILE_MAGIC, sizeof(_MATRIX_FILE_MAGIC));
+    head.version = _MATRIX_FILE_VERSION;
+    head.header = sizeof(head);
+    head.n = n;
+    head.nnz = nnz;
+    head.mode = 0 != mode;
+    _MatrixFileLayout(&head);
+
+    /*the file always starts ap at 0, so that it matches the arrays stored*/
+    rp = ap;
+    if (0 != ap[0])
+    {
+        rp = (int *)_HypamasMalloc(sizeof(int) * (n + 1));
+        if (NULL == rp)
+            return kErrorOutOfMemory;
+        for (i = 0; i <= n; ++i)
+            rp[i] = ap[i] - ap[0];
+    }
+
+    fp = fopen(file, "wb");
+    if (NULL == fp)
+    {
+        if (rp != ap)
+            _HypamasFree(rp);
+        return kErrorOpenFileFail;
+    }
+
+    retval = kHypamasOK;
+    if (1 != fwrite(&head, sizeof(head), 1, fp) ||
+        (size_t)(n + 1) != fwrite(rp, sizeof(int), n + 1, fp) ||
+        (size_t)(head.offset[1] - head.offset[0]) - sizeof(int) * (n + 1) != fwrite(zero, 1, head.offset[1] - head.offset[0] - sizeof(int) * (n + 1), fp) ||
+        (size_t)nnz != fwrite(ai + ap[0], sizeof(int), nnz, fp) ||
+        (size_t)(head.offset[2] - head.offset[1]) - sizeof(int) * nnz != fwrite(zero, 1, head.offset[2] - head.offset[1] - sizeof(int) * nnz, fp) ||
+        (size_t)nnz != fwrite(ax + ap[0], sizeof(double), nnz, fp))
+        retval = kErrorOpenFileFail;
+    if (0 != fclose(fp))
+        retval = kErrorOpenFileFail;
+    if (rp != ap)
+        _HypamasFree(rp);
+
+    return retval;
+}
+
+int Hypamas_MapBinaryMatrixFile(
+    IN__ char *file,
+    OUT__ int *n,
+    OUT__ int *nnz,
+    OUT__ double **ax,
+    OUT__ int **ap,
+    OUT__ int **ai,
+    OUT__ int *mode,
+    OUT__ void **map)
+{
+    _HypamasMatrixFileHeader *head, layout;
+    struct stat st;
+    void *base;
+    int *rp, fd;
+
+    if (NULL == file || NULL == n || NULL == nnz || NULL == ax || NULL == ap || NULL == ai || NULL == mode || NULL == map)
+        return kErrorInvalidArgument;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0)
+        return kErrorOpenFileFail;
+    if (0 != fstat(fd, &st) || st.st_size < (off_t)sizeof(_HypamasMatrixFileHeader))
+    {
+        close(fd);
+        return kErrorOpenFileFail;
+    }
+    /*private writable mapping, pages are copied only if the solver writes them*/
+    base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == base)
+        return kErrorOpenFileFail;
+
+    /*the offsets must be the layout of n & nnz, and ap must span ai, so that no array points out of the mapping*/
+    head = (_HypamasMatrixFileHeader *)base;
+    if (0 != memcmp(head->magic, _MATRIX_FILE_MAGIC, sizeof(_MATRIX_FILE_MAGIC)) ||
+        _MATRIX_FILE_VERSION != head->version || sizeof(_HypamasMatrixFileHeader) != head->header ||
+        head->n <= 0 || head->nnz < 0)
+    {
+        munmap(base, st.st_size);
+        return kErrorOpenFileFail;
+    }
+    layout.n = head->n;
+    layout.nnz = head->nnz;
+    _MatrixFileLayout(&layout);
+    if (0 != memcmp(layout.offset, head->offset, sizeof(layout.offset)) ||
+        layout.offset[2] + (long long)head->nnz * (long long)sizeof(double) != (long long)st.st_size)
+    {
+        munmap(base, st.st_size);
+        return kErrorOpenFileFail;
+    }
+    rp = (int *)((char *)base + head->offset[0]);
+    if (0 != rp[0] || head->nnz != rp[head->n])
+    {
+        munmap(base, st.st_size);
+        return kErrorMatrixConsistencyCheck;
+    }
+
+    *n = head->n;
+    *nnz = head->nnz;
+    *mode = head->mode;
+    *ap = (int *)((char *)base + head->offset[0]);
+    *ai = (int *)((char *)base + head->offset[1]);
+    *ax = (double *)((char *)base + head->offset[2]);
+    *map = base;
+
+    return kHypamasOK;
+}
+
+int Hypamas_UnmapBinaryMatrixFile(
+    IN__ void *map)
+{
+    _HypamasMatrixFileHeader *head;
+
+    if (NULL == map)
+        return kErrorInvalidArgument;
+
+    /*the file size was checked to end with ax*/
+    head = (_HypamasMatrixFileHeader *)map;
+    munmap(map, head->offset[2] + (long long)head->nnz * (long long)sizeof(double));
+
+    return kHypamasOK;
+}
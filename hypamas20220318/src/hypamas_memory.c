@@ -0,0 +1,357 @@
+/*used to define the allocator hooks and the per-thread scratch arenas of the extension*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include "hypamas_ext_internal.h"
+
+#define _ARENA_ALIGN 64               /* scratch blocks start on a cache line */
+#define _ARENA_GRANULE (64 << 10)     /* the reservation grows in multiples of it */
+#define _HUGE_PAGE_SIZE (2 << 20)     /* size of a huge page on x86-64 */
+#define _HUGE_PAGE_MIN (1 << 20)      /* smaller blocks of the huge page allocator come from malloc */
+#define _HUGE_HEADER 64               /* header in front of a block of the huge page allocator */
+
+/**
+ * @brief Allocator of the extension, libc if all callbacks are NULL
+ */
+typedef struct
+{
+    HypamasAllocProc alloc;
+    HypamasResizeProc resize;
+    HypamasReleaseProc release;
+    void *user;
+} _HypamasAllocator;
+
+static _HypamasAllocator g_allocator = {NULL, NULL, NULL, NULL};
+static long long g_alloc_count = 0;
+
+/**
+ * @brief Scratch arena of one thread, a bump allocator over one reservation.
+ * Requests beyond the reservation are served by overflow blocks, freed when the arena is emptied,
+ * and the reservation then grows to the peak, so a repeated call pattern stops allocating after its first run.
+ */
+typedef struct
+{
+    char *raw; /* reservation as allocated */
+    char *base; /* reservation aligned to _ARENA_ALIGN */
+    size_t size;
+    size_t used; /* may exceed size while overflow blocks are alive */
+    size_t peak;
+    void *chain;             /* overflow blocks, the first word of each points to the next */
+    _HypamasAllocator owner; /* the allocator the memory of the arena comes from */
+} _HypamasArena;
+
+static __thread _HypamasArena *t_arena = NULL;
+static pthread_key_t g_arena_key;
+static pthread_once_t g_arena_once = PTHREAD_ONCE_INIT;
+
+static void *_AllocWith(const _HypamasAllocator *a, size_t size)
+{
+    __atomic_add_fetch(&g_alloc_count, 1, __ATOMIC_RELAXED);
+    return NULL != a->alloc ? a->alloc(size, a->user) : malloc(size);
+}
+
+static void _ReleaseWith(const _HypamasAllocator *a, void *ptr)
+{
+    if (NULL == ptr)
+        return;
+    if (NULL != a->release)
+        a->release(ptr, a->user);
+    else
+        free(ptr);
+}
+
+void *_HypamasMalloc(
+    IN__ size_t size)
+{
+    return _AllocWith(&g_allocator, size);
+}
+
+void *_HypamasCalloc(
+    IN__ size_t count,
+    IN__ size_t size)
+{
+    void *p;
+
+    if (0 != size && count > SIZE_MAX / size)
+        return NULL;
+    if (NULL == g_allocator.alloc)
+    {
+        __atomic_add_fetch(&g_alloc_count, 1, __ATOMIC_RELAXED);
+        return calloc(count, size);
+    }
+    p = _AllocWith(&g_allocator, count * size);
+    if (NULL != p)
+        memset(p, 0, count * size);
+    return p;
+}
+
+void *_HypamasRealloc(
+    IN__ void *ptr,
+    IN__ size_t size)
+{
+    __atomic_add_fetch(&g_alloc_count, 1, __ATOMIC_RELAXED);
+    return NULL != g_allocator.resize ? g_allocator.resize(ptr, size, g_allocator.user) : realloc(ptr, size);
+}
+
+void _HypamasFree(
+    IN__ void *ptr)
+{
+    _ReleaseWith(&g_allocator, ptr);
+}
+
+static void _ArenaChainFree(_HypamasArena *a)
+{
+    void *next;
+
+    while (NULL != a->chain)
+    {
+        next = *(void **)a->chain;
+        _ReleaseWith(&a->owner, a->chain);
+        a->chain = next;
+    }
+}
+
+static void _ArenaDestroy(void *arena)
+{
+    _HypamasArena *a = (_HypamasArena *)arena;
+    _HypamasAllocator owner;
+
+    if (NULL == a)
+        return;
+    owner = a->owner;
+    _ArenaChainFree(a);
+    _ReleaseWith(&owner, a->raw);
+    _ReleaseWith(&owner, a);
+}
+
+static void _ArenaKeyCreate(void)
+{
+    pthread_key_create(&g_arena_key, _ArenaDestroy);
+}
+
+/*Arena of the calling thread, created on demand, NULL if out of memory.*/
+static _HypamasArena *_ArenaGet(void)
+{
+    _HypamasArena *a;
+
+    if (NULL != t_arena)
+        return t_arena;
+    pthread_once(&g_arena_once, _ArenaKeyCreate);
+    a = (_HypamasArena *)_AllocWith(&g_allocator, sizeof(_HypamasArena));
+    if (NULL == a)
+        return NULL;
+    memset(a, 0, sizeof(_HypamasArena));
+    a->owner = g_allocator;
+    pthread_setspecific(g_arena_key, a);
+    t_arena = a;
+    return a;
+}
+
+/*Replace the reservation of an empty arena by one of at least size bytes.*/
+static int _ArenaReserve(_HypamasArena *a, size_t size)
+{
+    char *raw;
+
+    size = (size + _ARENA_GRANULE - 1) / _ARENA_GRANULE * _ARENA_GRANULE;
+    if (size <= a->size)
+        return kHypamasOK;
+    raw = (char *)_AllocWith(&a->owner, size + _ARENA_ALIGN);
+    if (NULL == raw)
+        return kErrorOutOfMemory;
+    _ReleaseWith(&a->owner, a->raw);
+    a->raw = raw;
+    a->base = (char *)(((uintptr_t)raw + _ARENA_ALIGN - 1) & ~(uintptr_t)(_ARENA_ALIGN - 1));
+    a->size = size;
+    return kHypamasOK;
+}
+
+void *_HypamasArenaAlloc(
+    IN__ size_t size)
+{
+    _HypamasArena *a;
+    char *p;
+
+    a = _ArenaGet();
+    if (NULL == a)
+        return NULL;
+    size = (size + _ARENA_ALIGN - 1) / _ARENA_ALIGN * _ARENA_ALIGN;
+    if (a->used + size <= a->size)
+    {
+        p = a->base + a->used;
+    }
+    else
+    {
+        /*the first cache line of an overflow block links the chain*/
+        p = (char *)_AllocWith(&a->owner, size + 2 * _ARENA_ALIGN);
+        if (NULL == p)
+            return NULL;
+        *(void **)p = a->chain;
+        a->chain = p;
+        p = (char *)(((uintptr_t)p + 2 * _ARENA_ALIGN - 1) & ~(uintptr_t)(_ARENA_ALIGN - 1));
+    }
+    a->used += size;
+    a->peak = _HYPAMAS_MAX(a->peak, a->used);
+
+    return p;
+}
+
+size_t _HypamasArenaMark(void)
+{
+    return NULL != t_arena ? t_arena->used : 0;
+}
+
+void _HypamasArenaReset(
+    IN__ size_t mark)
+{
+    _HypamasArena *a = t_arena;
+
+    if (NULL == a)
+        return;
+    a->used = mark;
+    if (0 == mark && NULL != a->chain)
+    {
+        _ArenaChainFree(a);
+        _ArenaReserve(a, a->peak);
+    }
+}
+
+int Hypamas_SetAllocator(
+    IN__ HypamasAllocProc alloc,
+    IN__ HypamasResizeProc resize,
+    IN__ HypamasReleaseProc release,
+    IN__ void *user)
+{
+    if (!((NULL == alloc && NULL == resize && NULL == release) || (NULL != alloc && NULL != resize && NULL != release)))
+        return kErrorInvalidArgument;
+
+    /*the scratch of the calling thread is moved to the new allocator, those of other threads keep their owner until the thread exits*/
+    if (NULL != t_arena && 0 != t_arena->used)
+        return kErrorInvalidArgument;
+    if (NULL != t_arena)
+    {
+        _ArenaDestroy(t_arena);
+        pthread_setspecific(g_arena_key, NULL);
+        t_arena = NULL;
+    }
+
+    g_allocator.alloc = alloc;
+    g_allocator.resize = resize;
+    g_allocator.release = release;
+    g_allocator.user = user;
+
+    return kHypamasOK;
+}
+
+int Hypamas_ReserveScratch(
+    IN__ size_t size)
+{
+    _HypamasArena *a;
+
+    a = _ArenaGet();
+    if (NULL == a)
+        return kErrorOutOfMemory;
+    if (0 != a->used)
+        return kErrorInvalidArgument;
+    a->peak = _HYPAMAS_MAX(a->peak, size);
+    return _ArenaReserve(a, size);
+}
+
+int Hypamas_AllocationCount(
+    OUT__ long long *count)
+{
+    if (NULL == count)
+        return kErrorInvalidArgument;
+    *count = __atomic_load_n(&g_alloc_count, __ATOMIC_RELAXED);
+    return kHypamasOK;
+}
+
+/**
+ * @brief Header of a block of the huge page allocator, the data follows at _HUGE_HEADER
+ */
+typedef struct
+{
+    size_t size;   /* bytes requested */
+    size_t length; /* bytes mapped, 0 if the block comes from malloc */
+} _HugeHeader;
+
+void *Hypamas_HugePageAlloc(
+    IN__ size_t size,
+    IN__ void *user)
+{
+    _HugeHeader *h;
+    size_t length;
+    void *p;
+    (void)user;
+
+    if (size + _HUGE_HEADER < _HUGE_PAGE_MIN)
+    {
+        h = (_HugeHeader *)malloc(size + _HUGE_HEADER);
+        if (NULL == h)
+            return NULL;
+        h->length = 0;
+    }
+    else
+    {
+        /*explicit huge pages if reserved by the system, otherwise transparent huge pages*/
+        length = (size + _HUGE_HEADER + _HUGE_PAGE_SIZE - 1) / _HUGE_PAGE_SIZE * _HUGE_PAGE_SIZE;
+        p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (MAP_FAILED == p)
+        {
+            p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (MAP_FAILED == p)
+                return NULL;
+            madvise(p, length, MADV_HUGEPAGE);
+        }
+        h = (_HugeHeader *)p;
+        h->length = length;
+    }
+    h->size = size;
+
+    return (char *)h + _HUGE_HEADER;
+}
+
+void Hypamas_HugePageRelease(
+    IN__ void *ptr,
+    IN__ void *user)
+{
+    _HugeHeader *h;
+    (void)user;
+
+    if (NULL == ptr)
+        return;
+    h = (_HugeHeader *)((char *)ptr - _HUGE_HEADER);
+    if (0 == h->length)
+        free(h);
+    else
+        munmap(h, h->length);
+}
+
+void *Hypamas_HugePageResize(
+    IN__ void *ptr,
+    IN__ size_t size,
+    IN__ void *user)
+{
+    _HugeHeader *h;
+    void *p;
+
+    if (NULL == ptr)
+        return Hypamas_HugePageAlloc(size, user);
+    h = (_HugeHeader *)((char *)ptr - _HUGE_HEADER);
+    if (0 != h->length && size + _HUGE_HEADER <= h->length)
+    {
+        h->size = size;
+        return ptr;
+    }
+    p = Hypamas_HugePageAlloc(size, user);
+    if (NULL == p)
+        return NULL;
+    memcpy(p, ptr, _HYPAMAS_MIN(size, h->size));
+    Hypamas_HugePageRelease(ptr, user);
+
+    return p;
+}
@@ -0,0 +1,575 @@
+/*used to define the GMRES recycling a subspace across a sequence of systems and the reuse policy of its preconditioner*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <string.h>
+#include <math.h>
+#include "hypamas_ext_internal.h"
+
+#define _RECYCLE_STAGNATION_RATIO 0.99 /* residual must drop below this ratio of the best one to count as progress */
+#define _RECYCLE_STALE_RATIO 2.0       /* iterations over the baseline marking the preconditioner stale by default */
+#define _RECYCLE_MIN_GROWTH 10         /* iterations over the baseline below which the preconditioner is never stale */
+#define _RECYCLE_DROP 1e-10            /* norm left by the orthogonalization, relative to the one before, under which a vector is dependent */
+
+/**
+ * @brief Recycled subspace & reuse state of a sequence of systems
+ * A*u_i = c_i and C is orthonormal. U lives in the space of x, so a refreshed preconditioner keeps it valid,
+ * only new values of A require the images C again.
+ */
+typedef struct
+{
+    int k;        /* maximum dimension of the recycled subspace */
+    int count;    /* vectors held, the oldest first */
+    int n;
+    double *u;    /* k*n */
+    double *c;    /* k*n */
+    unsigned long long values; /* checksum of the ax C was computed from */
+    int valid;    /* non-zero if values is set */
+
+    double ratio;  /* iterations over the baseline marking the preconditioner stale */
+    int baseline;  /* iterations of the first solve after a refresh, -1 until measured */
+    int stale;     /* refresh before the next solve */
+    int refreshes; /* HypamasInFactorize called by the policy */
+    long long solves;
+    long long iterations;
+} _HypamasRecycle;
+
+static unsigned long long _RecycleChecksum(const double *ax, int nnz)
+{
+    unsigned long long h, bits;
+    int p;
+
+    /*FNV-1a over the bits of the values*/
+    h = 14695981039346656037ULL;
+    for (p = 0; p < nnz; ++p)
+    {
+        memcpy(&bits, ax + p, sizeof(bits));
+        h = (h ^ bits) * 1099511628211ULL;
+    }
+    return h;
+}
+
+/*y = A*x, ax, ap & ai are the CSC of A if transpose is set*/
+static void _RecycleSpMV(int n, const double *ax, const int *ap, const int *ai, int transpose, const double *x, double *y)
+{
+    double s;
+    int i, p;
+
+    if (transpose)
+    {
+        memset(y, 0, sizeof(double) * n);
+        for (i = 0; i < n; ++i)
+        {
+            s = x[i];
+            for (p = ap[i]; p < ap[i + 1]; ++p)
+                y[ai[p]] += ax[p] * s;
+        }
+        return;
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        s = 0.;
+        for (p = ap[i]; p < ap[i + 1]; ++p)
+            s += ax[p] * x[ai[p]];
+        y[i] = s;
+    }
+}
+
+static double _RecycleDot(int n, const double *x, const double *y)
+{
+    double s;
+    int i;
+
+    s = 0.;
+    for (i = 0; i < n; ++i)
+        s += x[i] * y[i];
+    return s;
+}
+
+static void _RecycleAxpy(int n, double a, const double *x, double *y)
+{
+    int i;
+
+    for (i = 0; i < n; ++i)
+        y[i] += a * x[i];
+}
+
+/*Orthogonalize c against C by modified Gram-Schmidt, the same combination applied to u, then normalize both.*/
+/*Returns 0 if c is dependent on C.*/
+static int _RecycleOrthogonalize(_HypamasRecycle *p, double *u, double *c)
+{
+    double a, norm, scale;
+    int i, n;
+
+    n = p->n;
+    scale = sqrt(_RecycleDot(n, c, c));
+    for (i = 0; i < p->count; ++i)
+    {
+        a = _RecycleDot(n, p->c + (size_t)i * n, c);
+        _RecycleAxpy(n, -a, p->c + (size_t)i * n, c);
+        _RecycleAxpy(n, -a, p->u + (size_t)i * n, u);
+    }
+    norm = sqrt(_RecycleDot(n, c, c));
+    if (norm <= _RECYCLE_DROP * scale || norm != norm)
+        return 0;
+    for (i = 0; i < n; ++i)
+    {
+        c[i] /= norm;
+        u[i] /= norm;
+    }
+    return 1;
+}
+
+/*Append (u, c) once orthonormalized, the oldest pair is dropped when the subspace is full.*/
+static void _RecycleInsert(_HypamasRecycle *p, double *u, double *c)
+{
+    size_t n;
+
+    if (!_RecycleOrthogonalize(p, u, c))
+        return;
+
+    n = (size_t)p->n;
+    if (p->count == p->k)
+    {
+        memmove(p->u, p->u + n, sizeof(double) * n * (p->k - 1));
+        memmove(p->c, p->c + n, sizeof(double) * n * (p->k - 1));
+        --p->count;
+    }
+    memcpy(p->u + n * p->count, u, sizeof(double) * n);
+    memcpy(p->c + n * p->count, c, sizeof(double) * n);
+    ++p->count;
+}
+
+/*C = A*U for new values of A, then U & C orthonormalized again, dependent pairs are dropped.*/
+static void _RecycleImages(_HypamasRecycle *p, const double *ax, const int *ap, const int *ai, int transpose, double *w)
+{
+    double *u, *c;
+    size_t n;
+    int i, count;
+
+    n = (size_t)p->n;
+    count = p->count;
+    p->count = 0;
+    for (i = 0; i < count; ++i)
+    {
+        u = p->u + n * i;
+        c = p->c + n * p->count;
+        _RecycleSpMV(p->n, ax, ap, ai, transpose, u, w);
+        memcpy(c, w, sizeof(double) * n);
+        if (u != p->u + n * p->count)
+            memcpy(p->u + n * p->count, u, sizeof(double) * n);
+        u = p->u + n * p->count;
+        if (_RecycleOrthogonalize(p, u, c))
+            ++p->count;
+    }
+}
+
+/*z = inv(M)*v by the (incomplete) factors of the handler, z = v if the preconditioner is off*/
+static int _RecyclePrecond(void *handler, int precond, double *v, double *z, int n, int threads)
+{
+    if (!precond)
+    {
+        memcpy(z, v, sizeof(double) * n);
+        return kHypamasOK;
+    }
+    return HypamasSolve(handler, v, z, threads);
+}
+
+static void _RecycleGivens(int k, double *h, double *cs, double *sn, double *g)
+{
+    double t, r;
+    int i;
+
+    for (i = 0; i < k; ++i)
+    {
+        t = cs[i] * h[i] + sn[i] * h[i + 1];
+        h[i + 1] = -sn[i] * h[i] + cs[i] * h[i + 1];
+        h[i] = t;
+    }
+    r = hypot(h[k], h[k + 1]);
+    if (0. == r)
+    {
+        cs[k] = 1.;
+        sn[k] = 0.;
+    }
+    else
+    {
+        cs[k] = h[k] / r;
+        sn[k] = h[k + 1] / r;
+    }
+    h[k] = r;
+    h[k + 1] = 0.;
+    g[k + 1] = -sn[k] * g[k];
+    g[k] = cs[k] * g[k];
+}
+
+/*GCRO with right preconditioning: the Arnoldi process runs on (I-C*C')*A*inv(M), the residual is kept orthogonal to C,*/
+/*and the correction of every cycle joins the recycled subspace.*/
+static int _RecycleSolve(_HypamasRecycle *p, _HypamasHandler *h, const double *ax, const int *ap, const int *ai,
+                         const double *b, double *x, int threads, int *iterations)
+{
+    double *V, *z, *w, *r, *H, *B, *cs, *sn, *g, *y, *hk;
+    double bnorm, beta, tol, resid, best, a, s;
+    int n, m, k, ldh, maxiter, stagnation, transpose, precond, iter, stall, breakdown, retval, i, j, q;
+    size_t mark;
+
+    n = p->n;
+    k = p->k;
+    m = _HYPAMAS_MAX(1, h->iparm[kIparmKrylovDimension]);
+    ldh = m + 1;
+    maxiter = _HYPAMAS_MAX(0, h->iparm[kIparmKrylovMaxIter]);
+    stagnation = h->iparm[kIparmStagnationStep] > 0 ? h->iparm[kIparmStagnationStep] : maxiter + 1;
+    transpose = 0 != h->iparm[kIparmSolveTranspose];
+    precond = kCfgInFactPreconditionerOff != h->iparm[kIparmInFactAlgorithm];
+    iter = 0;
+    stall = 0;
+    retval = kHypamasOK;
+
+    mark = _HypamasArenaMark();
+    V = (double *)_HypamasArenaAlloc(sizeof(double) * ((size_t)(m + 4) * n + (size_t)ldh * m + (size_t)_HYPAMAS_MAX(1, k) * m + 4 * (size_t)ldh));
+    if (NULL == V)
+    {
+        _HypamasArenaReset(mark);
+        return kErrorOutOfMemory;
+    }
+    z = V + (size_t)(m + 1) * n;
+    w = z + n;
+    r = w + n;
+    H = r + n;
+    B = H + (size_t)ldh * m;
+    cs = B + (size_t)_HYPAMAS_MAX(1, k) * m;
+    sn = cs + ldh;
+    g = sn + ldh;
+    y = g + ldh;
+
+    /*the images of the recycled subspace follow the values of A*/
+    if (p->count > 0 && (!p->valid || _RecycleChecksum(ax, ap[n]) != p->values))
+        _RecycleImages(p, ax, ap, ai, transpose, w);
+    p->values = _RecycleChecksum(ax, ap[n]);
+    p->valid = 1;
+
+    /*r = b - A*x, then its part in range(C) removed by x = x + U*C'*r*/
+    _RecycleSpMV(n, ax, ap, ai, transpose, x, r);
+    for (i = 0; i < n; ++i)
+        r[i] = b[i] - r[i];
+    bnorm = sqrt(_RecycleDot(n, b, b));
+    if (0. == bnorm)
+    {
+        memset(x, 0, sizeof(double) * n);
+        goto FINAL;
+    }
+    for (i = 0; i < p->count; ++i)
+    {
+        a = _RecycleDot(n, p->c + (size_t)i * n, r);
+        _RecycleAxpy(n, a, p->u + (size_t)i * n, x);
+        _RecycleAxpy(n, -a, p->c + (size_t)i * n, r);
+    }
+    beta = sqrt(_RecycleDot(n, r, r));
+    tol = h->dparm[kDparmGMRESMetricTolerance] * bnorm;
+    best = beta;
+
+    while (1)
+    {
+        if (beta <= tol)
+            break;
+        if (beta != beta)
+        {
+            retval = kWarningIterationConvergeFail;
+            break;
+        }
+        if (iter >= maxiter)
+        {
+            retval = kWarningMaxIterationAchieved;
+            break;
+        }
+        if (stall >= stagnation)
+        {
+            retval = kWarningIterationConvergeSlowly;
+            break;
+        }
+
+        for (i = 0; i < n; ++i)
+            V[i] = r[i] / beta;
+        memset(g, 0, sizeof(double) * ldh);
+        g[0] = beta;
+
+        /*Arnoldi process, B = C'*A*inv(M)*V*/
+        j = 0;
+        breakdown = 0;
+        while (j < m && iter < maxiter)
+        {
+            retval = _RecyclePrecond(h, precond, V + (size_t)j * n, z, n, threads);
+            if (FAIL(retval))
+                goto FINAL;
+            _RecycleSpMV(n, ax, ap, ai, transpose, z, w);
+
+            for (i = 0; i < p->count; ++i)
+            {
+                a = _RecycleDot(n, p->c + (size_t)i * n, w);
+                B[i + (size_t)j * k] = a;
+                _RecycleAxpy(n, -a, p->c + (size_t)i * n, w);
+            }
+            hk = H + (size_t)j * ldh;
+            for (i = 0; i <= j; ++i)
+            {
+                hk[i] = _RecycleDot(n, V + (size_t)i * n, w);
+                _RecycleAxpy(n, -hk[i], V + (size_t)i * n, w);
+            }
+            hk[j + 1] = sqrt(_RecycleDot(n, w, w));
+            if (0. == hk[j + 1])
+                breakdown = 1;
+            else
+            {
+                s = 1. / hk[j + 1];
+                for (i = 0; i < n; ++i)
+                    V[(size_t)(j + 1) * n + i] = w[i] * s;
+            }
+
+            _RecycleGivens(j, hk, cs, sn, g);
+            resid = fabs(g[j + 1]);
+            ++j;
+            ++iter;
+
+            if (resid != resid)
+            {
+                retval = kWarningIterationConvergeFail;
+                goto FINAL;
+            }
+            if (resid < _RECYCLE_STAGNATION_RATIO * best)
+            {
+                best = resid;
+                stall = 0;
+            }
+            else
+                ++stall;
+            if (resid <= tol || breakdown || stall >= stagnation)
+                break;
+        }
+
+        /*y = inv(H)*g, the correction d = inv(M)*V*y - U*B*y*/
+        for (i = j - 1; i >= 0; --i)
+        {
+            s = g[i];
+            for (q = i + 1; q < j; ++q)
+                s -= H[i + (size_t)q * ldh] * y[q];
+            y[i] = 0. == H[i + (size_t)i * ldh] ? 0. : s / H[i + (size_t)i * ldh];
+        }
+        memset(w, 0, sizeof(double) * n);
+        for (q = 0; q < j; ++q)
+            _RecycleAxpy(n, y[q], V + (size_t)q * n, w);
+        retval = _RecyclePrecond(h, precond, w, z, n, threads);
+        if (FAIL(retval))
+            goto FINAL;
+        for (i = 0; i < p->count; ++i)
+        {
+            s = 0.;
+            for (q = 0; q < j; ++q)
+                s += B[i + (size_t)q * k] * y[q];
+            _RecycleAxpy(n, -s, p->u + (size_t)i * n, z);
+        }
+        _RecycleAxpy(n, 1., z, x);
+
+        /*true residual, a cycle not reducing it is below the attainable accuracy and undone, its correction would spoil U*/
+        _RecycleSpMV(n, ax, ap, ai, transpose, x, w);
+        for (i = 0; i < n; ++i)
+            w[i] = b[i] - w[i];
+        s = sqrt(_RecycleDot(n, w, w));
+        if (!(s < beta))
+        {
+            _RecycleAxpy(n, -1., z, x);
+            retval = s <= tol ? kHypamasOK : kWarningIterationConvergeSlowly;
+            break;
+        }
+        memcpy(r, w, sizeof(double) * n);
+
+        /*d joins U with A*d in C, not taken as the difference of the residuals which cancels once they stagnate*/
+        if (p->k > 0)
+        {
+            _RecycleSpMV(n, ax, ap, ai, transpose, z, V);
+            _RecycleInsert(p, z, V);
+            if (p->count > 0)
+            {
+                a = _RecycleDot(n, p->c + (size_t)(p->count - 1) * n, r);
+                _RecycleAxpy(n, a, p->u + (size_t)(p->count - 1) * n, x);
+                _RecycleAxpy(n, -a, p->c + (size_t)(p->count - 1) * n, r);
+            }
+        }
+        beta = sqrt(_RecycleDot(n, r, r));
+    }
+
+FINAL:
+
+    _HypamasArenaReset(mark);
+    *iterations = iter;
+
+    return retval;
+}
+
+int HypamasRecycleInit(
+    OUT__ void **recycle,
+    IN__ int k,
+    IN__ double ratio)
+{
+    _HypamasRecycle *p;
+
+    if (NULL == recycle || k < 0)
+        return kErrorInvalidArgument;
+
+    p = (_HypamasRecycle *)_HypamasCalloc(1, sizeof(_HypamasRecycle));
+    if (NULL == p)
+        return kErrorOutOfMemory;
+    p->k = k;
+    p->ratio = ratio > 0. ? ratio : _RECYCLE_STALE_RATIO;
+    p->baseline = -1;
+    *recycle = p;
+
+    return kHypamasOK;
+}
+
+int HypamasRecycleFinalize(
+    IN__ void *recycle)
+{
+    _HypamasRecycle *p;
+
+    if (NULL == recycle)
+        return kErrorInvalidArgument;
+
+    p = (_HypamasRecycle *)recycle;
+    _HypamasFree(p->u);
+    _HypamasFree(p->c);
+    _HypamasFree(p);
+
+    return kHypamasOK;
+}
+
+int HypamasRecycleInfo(
+    IN__ void *recycle,
+    OUT__ int *dimension,
+    OUT__ long long *iterations,
+    OUT__ int *refreshes)
+{
+    _HypamasRecycle *p;
+
+    if (NULL == recycle)
+        return kErrorInvalidArgument;
+
+    p = (_HypamasRecycle *)recycle;
+    if (NULL != dimension)
+        *dimension = p->count;
+    if (NULL != iterations)
+        *iterations = p->iterations;
+    if (NULL != refreshes)
+        *refreshes = p->refreshes;
+
+    return kHypamasOK;
+}
+
+/*the solve ended without converging*/
+static int _RecycleStalled(int retval)
+{
+    return kWarningMaxIterationAchieved == retval || kWarningIterationConvergeSlowly == retval || kWarningIterationConvergeFail == retval;
+}
+
+int HypamasRecycleGMRES(
+    INOUT__ void *handler,
+    INOUT__ void *recycle,
+    IN__ double *ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ double *rhs,
+    INOUT__ double *sol,
+    IN__ int threads)
+{
+    _HypamasHandler *h;
+    _HypamasRecycle *p;
+    double t0;
+    long long start;
+    int retval, precond, refreshed, iter, total;
+
+    if (NULL == handler || NULL == recycle || NULL == ax || NULL == ap || NULL == ai || NULL == rhs || NULL == sol)
+        return kErrorInvalidArgument;
+
+    h = _HYPAMAS_HANDLER(handler);
+    if (!_HYPAMAS_INITIALIZED(h))
+        return kErrorPhaseNotInitialized;
+    if (!_HYPAMAS_ANALYZED(h))
+        return kErrorPhaseNotAnalyzed;
+
+    t0 = _HypamasWallTime();
+    start = _HypamasTraceClock();
+    p = (_HypamasRecycle *)recycle;
+    if (threads <= 0)
+        threads = h->iparm[kIparmThreadCreated];
+    threads = _HYPAMAS_MAX(1, threads);
+
+    /*a new dimension starts the sequence again*/
+    if (p->n != h->n)
+    {
+        _HypamasFree(p->u);
+        _HypamasFree(p->c);
+        p->u = p->c = NULL;
+        p->count = 0;
+        p->valid = 0;
+        p->n = h->n;
+        if (p->k > 0)
+        {
+            p->u = (double *)_HypamasMalloc(sizeof(double) * p->k * (size_t)p->n);
+            p->c = (double *)_HypamasMalloc(sizeof(double) * p->k * (size_t)p->n);
+            if (NULL == p->u || NULL == p->c)
+            {
+                _HypamasFree(p->u);
+                _HypamasFree(p->c);
+                p->u = p->c = NULL;
+                p->n = 0;
+                return kErrorOutOfMemory;
+            }
+        }
+    }
+
+    /*the factors are kept until the iterations show they are stale*/
+    precond = kCfgInFactPreconditionerOff != h->iparm[kIparmInFactAlgorithm];
+    refreshed = 0;
+    if (precond && (!_HYPAMAS_FACTORIZED(h) || p->stale))
+    {
+        retval = HypamasInFactorize(handler, ax, threads);
+        if (FAIL(retval))
+            return retval;
+        ++p->refreshes;
+        p->stale = 0;
+        p->baseline = -1;
+        refreshed = 1;
+    }
+
+    retval = _RecycleSolve(p, h, ax, ap, ai, rhs, sol, threads, &iter);
+    total = iter;
+    if (OK(retval) && precond && !refreshed && _RecycleStalled(retval))
+    {
+        /*stale factors, refreshed from the current values and the solve goes on from sol*/
+        retval = HypamasInFactorize(handler, ax, threads);
+        if (FAIL(retval))
+            return retval;
+        ++p->refreshes;
+        p->baseline = -1;
+        refreshed = 1;
+        retval = _RecycleSolve(p, h, ax, ap, ai, rhs, sol, threads, &iter);
+        total += iter;
+    }
+    if (OK(retval) && precond)
+    {
+        if (refreshed || p->baseline < 0)
+            p->baseline = _HYPAMAS_MAX(1, iter);
+        else if (iter > p->ratio * p->baseline && iter >= p->baseline + _RECYCLE_MIN_GROWTH)
+            p->stale = 1;
+    }
+
+    ++p->solves;
+    p->iterations += total;
+    h->iparm[kIparmIterNum] = total;
+    h->iparm[kIparmThreadUsed] = threads;
+    if (h->iparm[kIparmTimer])
+        h->dparm[kDparmSolveTime] = _HypamasWallTime() - t0;
+    _HypamasTraceRecord(kTracePhaseGMRES, start, total * (2. * ap[h->n] + 2. * h->n * (h->iparm[kIparmKrylovDimension] / 2 + p->count)));
+
+    return retval;
+}
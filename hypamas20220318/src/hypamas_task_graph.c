@@ -0,0 +1,224 @@
+/*used to define the work-stealing executor of dependency graphs run by the thread team*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <sched.h>
+#include <immintrin.h>
+#include "hypamas_ext_internal.h"
+
+#define _GRAPH_SPIN_COUNT 4000 /* pause rounds of an idle thread before yielding the core */
+
+/**
+ * @brief Ready nodes of one thread, the owner works at the bottom and thieves take from the top.
+ * A node is pushed once per run, so n entries never overflow.
+ */
+typedef struct
+{
+    int lock;
+    int top;
+    int bottom;
+    int steals; /* nodes taken from other threads in the last run */
+    char pad[48];
+} _GraphDeque;
+
+struct _HypamasTaskGraph
+{
+    int n;
+    const int *sp; /* successors of node k are si[sp[k]:sp[k+1]] */
+    const int *si;
+    const int *indeg; /* number of predecessors */
+
+    int threads; /* deques allocated */
+    _GraphDeque *deque;
+    int *items; /* n per thread */
+    int *count; /* predecessors not finished */
+    int done;   /* nodes finished */
+};
+
+int _HypamasTaskGraphCreate(
+    OUT__ _HypamasTaskGraph **graph,
+    IN__ int n,
+    IN__ const int *sp,
+    IN__ const int *si,
+    IN__ const int *indeg,
+    IN__ int threads)
+{
+    _HypamasTaskGraph *g;
+
+    g = (_HypamasTaskGraph *)_HypamasCalloc(1, sizeof(_HypamasTaskGraph));
+    if (NULL == g)
+        return kErrorOutOfMemory;
+    g->n = n;
+    g->sp = sp;
+    g->si = si;
+    g->indeg = indeg;
+    g->threads = threads;
+    g->deque = (_GraphDeque *)_HypamasCalloc(threads, sizeof(_GraphDeque));
+    g->items = (int *)_HypamasMalloc(sizeof(int) * n * threads);
+    g->count = (int *)_HypamasMalloc(sizeof(int) * n);
+    if (NULL == g->deque || NULL == g->items || NULL == g->count)
+    {
+        _HypamasTaskGraphFree(g);
+        return kErrorOutOfMemory;
+    }
+
+    *graph = g;
+    return kHypamasOK;
+}
+
+void _HypamasTaskGraphFree(
+    IN__ _HypamasTaskGraph *graph)
+{
+    if (NULL == graph)
+        return;
+    _HypamasFree(graph->deque);
+    _HypamasFree(graph->items);
+    _HypamasFree(graph->count);
+    _HypamasFree(graph);
+}
+
+int _HypamasTaskGraphThreads(
+    IN__ const _HypamasTaskGraph *graph)
+{
+    return graph->threads;
+}
+
+int _HypamasTaskGraphSteals(
+    IN__ const _HypamasTaskGraph *graph)
+{
+    int i, steals;
+
+    steals = 0;
+    for (i = 0; i < graph->threads; ++i)
+        steals += graph->deque[i].steals;
+    return steals;
+}
+
+static inline void _GraphLock(_GraphDeque *d)
+{
+    while (__atomic_exchange_n(&d->lock, 1, __ATOMIC_ACQUIRE))
+    {
+        while (__atomic_load_n(&d->lock, __ATOMIC_RELAXED))
+            _mm_pause();
+    }
+}
+
+static inline void _GraphUnlock(_GraphDeque *d)
+{
+    __atomic_store_n(&d->lock, 0, __ATOMIC_RELEASE);
+}
+
+static inline void _GraphPush(_HypamasTaskGraph *g, int tid, int k)
+{
+    _GraphDeque *d = g->deque + tid;
+
+    _GraphLock(d);
+    g->items[(size_t)tid * g->n + d->bottom++] = k;
+    _GraphUnlock(d);
+}
+
+/*Newest node of the own deque, the one most likely in cache, -1 if empty.*/
+static inline int _GraphPop(_HypamasTaskGraph *g, int tid)
+{
+    _GraphDeque *d = g->deque + tid;
+    int k = -1;
+
+    if (__atomic_load_n(&d->bottom, __ATOMIC_RELAXED) == __atomic_load_n(&d->top, __ATOMIC_RELAXED))
+        return -1;
+    _GraphLock(d);
+    if (d->bottom > d->top)
+        k = g->items[(size_t)tid * g->n + --d->bottom];
+    _GraphUnlock(d);
+    return k;
+}
+
+/*Oldest node of the deque of victim, -1 if empty.*/
+static inline int _GraphSteal(_HypamasTaskGraph *g, int victim)
+{
+    _GraphDeque *d = g->deque + victim;
+    int k = -1;
+
+    if (__atomic_load_n(&d->bottom, __ATOMIC_RELAXED) == __atomic_load_n(&d->top, __ATOMIC_RELAXED))
+        return -1;
+    _GraphLock(d);
+    if (d->bottom > d->top)
+        k = g->items[(size_t)victim * g->n + d->top++];
+    _GraphUnlock(d);
+    return k;
+}
+
+void _HypamasTaskGraphRun(
+    INOUT__ _HypamasTaskGraph *graph,
+    IN__ _HypamasTeam *team,
+    IN__ int tid,
+    IN__ int threads,
+    IN__ _HypamasNodeProc proc,
+    IN__ void *arg)
+{
+    _HypamasTaskGraph *g = graph;
+    int lo, hi, i, k, q, s, victim, spin;
+    long long tasks, idle;
+
+    lo = (int)((long long)g->n * tid / threads);
+    hi = (int)((long long)g->n * (tid + 1) / threads);
+    for (i = lo; i < hi; ++i)
+        g->count[i] = g->indeg[i];
+    g->deque[tid].top = 0;
+    g->deque[tid].bottom = 0;
+    g->deque[tid].steals = 0;
+    if (0 == tid)
+        g->done = 0;
+    _HypamasTeamBarrier(team, threads);
+
+    for (i = lo; i < hi; ++i)
+    {
+        if (0 == g->indeg[i])
+            _GraphPush(g, tid, i);
+    }
+
+    spin = 0;
+    tasks = 0;
+    idle = 0; /* trace clock since the thread found no ready node */
+    while (1)
+    {
+        k = _GraphPop(g, tid);
+        for (victim = tid + 1; k < 0 && victim < tid + threads; ++victim)
+        {
+            k = _GraphSteal(g, victim % threads);
+            if (k >= 0)
+                ++g->deque[tid].steals;
+        }
+        if (k < 0)
+        {
+            if (0 == spin)
+                idle = _HypamasTraceClock();
+            if (g->n == __atomic_load_n(&g->done, __ATOMIC_ACQUIRE))
+                break;
+            if (++spin < _GRAPH_SPIN_COUNT)
+                _mm_pause();
+            else
+                sched_yield();
+            continue;
+        }
+        if (0 != spin)
+            _HypamasTraceRecord(kTracePhaseWait, idle, 0.);
+        spin = 0;
+        ++tasks;
+
+        proc(arg, k, tid);
+
+        /*the release of the counter publishes the results of k to the thread running a successor*/
+        for (q = g->sp[k]; q < g->sp[k + 1]; ++q)
+        {
+            s = g->si[q];
+            if (0 == __atomic_sub_fetch(&g->count[s], 1, __ATOMIC_ACQ_REL))
+                _GraphPush(g, tid, s);
+        }
+        __atomic_add_fetch(&g->done, 1, __ATOMIC_RELEASE);
+    }
+    _HypamasTraceRecord(kTracePhaseWait, idle, 0.);
+    _HypamasTraceTasks(tasks);
+
+    _HypamasTeamBarrier(team, threads);
+}
@@ -0,0 +1,401 @@
+/*used to define the thread team executing parallel regions of the extension*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <immintrin.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "hypamas_ext_internal.h"
+
+#define _TEAM_SPIN_COUNT 4000 /* default pause rounds before sleeping on a futex */
+
+struct _HypamasTeam
+{
+    int size; /* number of threads, including the calling thread */
+    pthread_t *threads;
+    int generation; /* odd while a region is set up, even once it is published, the futex the idle workers sleep on */
+    int active;     /* number of threads of the current region */
+    int pending;    /* workers of the current region not finished, the futex the caller sleeps on */
+    int quit;
+    _HypamasTaskProc proc;
+    void *arg;
+    double start; /* wall time the current region was started */
+    int barrier_count;
+    int barrier_generation;
+    int sleepers; /* workers sleeping on generation */
+    int waiting;  /* the caller sleeps on pending */
+    int barrier_sleepers;
+};
+
+typedef struct
+{
+    _HypamasTeam *team;
+    int tid;
+} _HypamasTeamWorker;
+
+static pthread_mutex_t g_team_lock = PTHREAD_MUTEX_INITIALIZER;
+static _HypamasTeam *g_team = NULL;
+static int g_team_spin = _TEAM_SPIN_COUNT;
+static int g_team_parked = 0;
+
+/*wake-up latency of the workers in nanoseconds, the counters only grow and a reset moves the base*/
+static long long g_wake_total = 0;
+static long long g_wake_count = 0;
+static long long g_wake_max = 0;
+static long long g_wake_base_total = 0;
+static long long g_wake_base_count = 0;
+
+static void _FutexWait(int *addr, int value)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void _FutexWake(int *addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+/*Pause rounds to spin before sleeping, zero while the pool is parked.*/
+static inline int _TeamSpin(void)
+{
+    return __atomic_load_n(&g_team_parked, __ATOMIC_RELAXED) ? 0 : __atomic_load_n(&g_team_spin, __ATOMIC_RELAXED);
+}
+
+/*Spin while *addr == value, then sleep on it. sleepers counts the threads that may sleep, so the waker skips the system call otherwise.*/
+static void _TeamWait(int *addr, int value, int *sleepers)
+{
+    int spin, budget;
+
+    budget = _TeamSpin();
+    for (spin = 0; spin < budget; ++spin)
+    {
+        if (value != __atomic_load_n(addr, __ATOMIC_ACQUIRE))
+            return;
+        _mm_pause();
+        if (0 == (spin & 63))
+            budget = _TeamSpin();
+    }
+    while (value == __atomic_load_n(addr, __ATOMIC_ACQUIRE))
+    {
+        __atomic_add_fetch(sleepers, 1, __ATOMIC_SEQ_CST);
+        if (value == __atomic_load_n(addr, __ATOMIC_SEQ_CST))
+            _FutexWait(addr, value);
+        __atomic_sub_fetch(sleepers, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+static void _TeamWake(int *addr, int *sleepers)
+{
+    if (0 != __atomic_load_n(sleepers, __ATOMIC_SEQ_CST))
+        _FutexWake(addr);
+}
+
+static void _TeamRecordWake(double start)
+{
+    long long ns, max;
+
+    ns = (long long)(1e9 * (_HypamasWallTime() - start));
+    __atomic_add_fetch(&g_wake_total, ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_wake_count, 1, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&g_wake_max, __ATOMIC_RELAXED);
+    while (ns > max && !__atomic_compare_exchange_n(&g_wake_max, &max, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void *_HypamasTeamThreadProc(void *arg)
+{
+    _HypamasTeamWorker *worker;
+    _HypamasTeam *team;
+    int tid, seen, generation, active;
+    long long start;
+    _HypamasTaskProc proc;
+    void *region;
+
+    worker = (_HypamasTeamWorker *)arg;
+    team = worker->team;
+    tid = worker->tid;
+    free(worker);
+
+    /*the team is created with generation zero, a region may have started before this thread runs*/
+    seen = 0;
+    while (1)
+    {
+        _TeamWait(&team->generation, seen, &team->sleepers);
+        generation = __atomic_load_n(&team->generation, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&team->quit, __ATOMIC_ACQUIRE))
+            break;
+        if (generation == seen)
+            continue;
+        if (generation & 1)
+        {
+            _mm_pause();
+            continue;
+        }
+
+        /*a worker not in this region may read the next one while it is set up, the generation tells*/
+        active = team->active;
+        proc = team->proc;
+        region = team->arg;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (generation != __atomic_load_n(&team->generation, __ATOMIC_ACQUIRE))
+            continue;
+        seen = generation;
+        if (tid >= active)
+            continue;
+
+        _TeamRecordWake(team->start);
+        start = _HypamasTraceClock();
+        proc(region, tid, active);
+        _HypamasTraceRecord(kTracePhaseRegion, start, 0.);
+
+        if (0 == __atomic_sub_fetch(&team->pending, 1, __ATOMIC_SEQ_CST))
+            _TeamWake(&team->pending, &team->waiting);
+    }
+
+    return NULL;
+}
+
+static void _HypamasTeamDestroy(_HypamasTeam *team)
+{
+    int i;
+
+    if (NULL == team)
+        return;
+
+    __atomic_store_n(&team->quit, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&team->generation, 2, __ATOMIC_SEQ_CST);
+    _FutexWake(&team->generation);
+
+    for (i = 1; i < team->size; ++i)
+        pthread_join(team->threads[i], NULL);
+
+    free(team->threads);
+    free(team);
+}
+
+static int _HypamasTeamCreate(_HypamasTeam **team, int size)
+{
+    _HypamasTeam *t;
+    _HypamasTeamWorker *worker;
+    int i;
+
+    t = (_HypamasTeam *)calloc(1, sizeof(_HypamasTeam));
+    if (NULL == t)
+        return kErrorOutOfMemory;
+    t->threads = (pthread_t *)calloc(size, sizeof(pthread_t));
+    if (NULL == t->threads)
+    {
+        free(t);
+        return kErrorOutOfMemory;
+    }
+
+    t->size = 1;
+    for (i = 1; i < size; ++i)
+    {
+        worker = (_HypamasTeamWorker *)malloc(sizeof(_HypamasTeamWorker));
+        if (NULL == worker)
+            break;
+        worker->team = t;
+        worker->tid = i;
+        if (0 != pthread_create(&t->threads[i], NULL, _HypamasTeamThreadProc, worker))
+        {
+            free(worker);
+            break;
+        }
+        t->size = i + 1;
+    }
+    if (t->size < size)
+    {
+        _HypamasTeamDestroy(t);
+        return kErrorThreadInitializeFail;
+    }
+
+    *team = t;
+    return kHypamasOK;
+}
+
+int _HypamasTeamAcquire(
+    OUT__ _HypamasTeam **team,
+    IN__ int threads)
+{
+    _HypamasTeam *t;
+    int retval;
+
+    pthread_mutex_lock(&g_team_lock);
+    if (threads > 1 && (NULL == g_team || g_team->size < threads))
+    {
+        retval = _HypamasTeamCreate(&t, threads);
+        if (FAIL(retval))
+        {
+            pthread_mutex_unlock(&g_team_lock);
+            return retval;
+        }
+        _HypamasTeamDestroy(g_team);
+        g_team = t;
+    }
+    *team = g_team;
+
+    return kHypamasOK;
+}
+
+void _HypamasTeamRelease(
+    IN__ _HypamasTeam *team)
+{
+    (void)team;
+    pthread_mutex_unlock(&g_team_lock);
+}
+
+void _HypamasTeamRun(
+    IN__ _HypamasTeam *team,
+    IN__ int threads,
+    IN__ _HypamasTaskProc proc,
+    IN__ void *arg)
+{
+    int pending;
+    long long start, wait;
+
+    start = _HypamasTraceClock();
+    if (NULL == team || threads <= 1)
+    {
+        proc(arg, 0, 1);
+        _HypamasTraceRecord(kTracePhaseRegion, start, 0.);
+        return;
+    }
+    if (threads > team->size)
+        threads = team->size;
+
+    /*the workers read the region after they see the new even generation*/
+    __atomic_add_fetch(&team->generation, 1, __ATOMIC_SEQ_CST);
+    team->proc = proc;
+    team->arg = arg;
+    team->active = threads;
+    team->pending = threads - 1;
+    team->barrier_count = 0;
+    team->start = _HypamasWallTime();
+    __atomic_add_fetch(&team->generation, 1, __ATOMIC_SEQ_CST);
+    _TeamWake(&team->generation, &team->sleepers);
+
+    proc(arg, 0, threads);
+
+    /*the caller waits inside its region for the workers to finish*/
+    wait = _HypamasTraceClock();
+    while (0 != (pending = __atomic_load_n(&team->pending, __ATOMIC_ACQUIRE)))
+        _TeamWait(&team->pending, pending, &team->waiting);
+    _HypamasTraceRecord(kTracePhaseWait, wait, 0.);
+    _HypamasTraceRecord(kTracePhaseRegion, start, 0.);
+}
+
+void _HypamasTeamBarrier(
+    IN__ _HypamasTeam *team,
+    IN__ int threads)
+{
+    int generation;
+    long long start;
+
+    if (threads <= 1)
+        return;
+
+    generation = __atomic_load_n(&team->barrier_generation, __ATOMIC_ACQUIRE);
+    if (threads == __atomic_add_fetch(&team->barrier_count, 1, __ATOMIC_ACQ_REL))
+    {
+        __atomic_store_n(&team->barrier_count, 0, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&team->barrier_generation, 1, __ATOMIC_SEQ_CST);
+        _TeamWake(&team->barrier_generation, &team->barrier_sleepers);
+        return;
+    }
+
+    start = _HypamasTraceClock();
+    _TeamWait(&team->barrier_generation, generation, &team->barrier_sleepers);
+    _HypamasTraceRecord(kTracePhaseWait, start, 0.);
+}
+
+int Hypamas_SetThreadPoolSpin(
+    IN__ int spin)
+{
+    if (spin < 0)
+        return kErrorInvalidArgument;
+
+    __atomic_store_n(&g_team_spin, spin, __ATOMIC_RELAXED);
+    return kHypamasOK;
+}
+
+int Hypamas_ParkThreadPool(void)
+{
+    __atomic_store_n(&g_team_parked, 1, __ATOMIC_RELAXED);
+    return kHypamasOK;
+}
+
+int Hypamas_UnparkThreadPool(void)
+{
+    _HypamasTeam *team;
+
+    __atomic_store_n(&g_team_parked, 0, __ATOMIC_RELAXED);
+
+    /*sleeping workers wake up and spin again, so the next region starts without a system call*/
+    pthread_mutex_lock(&g_team_lock);
+    team = g_team;
+    if (NULL != team)
+        _FutexWake(&team->generation);
+    pthread_mutex_unlock(&g_team_lock);
+
+    return kHypamasOK;
+}
+
+void _HypamasTeamWakeCounters(
+    OUT__ long long *total,
+    OUT__ long long *count)
+{
+    *total = __atomic_load_n(&g_wake_total, __ATOMIC_RELAXED);
+    *count = __atomic_load_n(&g_wake_count, __ATOMIC_RELAXED);
+}
+
+int Hypamas_ThreadPoolWakeLatency(
+    OUT__ double *average,
+    OUT__ double *maximum,
+    IN__ int reset)
+{
+    long long total, count, max;
+
+    total = __atomic_load_n(&g_wake_total, __ATOMIC_RELAXED);
+    count = __atomic_load_n(&g_wake_count, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&g_wake_max, __ATOMIC_RELAXED);
+    if (NULL != average)
+        *average = count > g_wake_base_count ? 1e-9 * (double)(total - g_wake_base_total) / (double)(count - g_wake_base_count) : 0.;
+    if (NULL != maximum)
+        *maximum = 1e-9 * (double)max;
+    if (reset)
+    {
+        g_wake_base_total = total;
+        g_wake_base_count = count;
+        __atomic_store_n(&g_wake_max, 0, __ATOMIC_RELAXED);
+    }
+
+    return kHypamasOK;
+}
+
+void _HypamasPartitionRows(
+    IN__ int n,
+    IN__ const int *ap,
+    IN__ int weight,
+    IN__ int parts,
+    OUT__ int *part)
+{
+    long long total, target;
+    int t, i;
+
+    total = (long long)(ap[n] - ap[0]) + (long long)weight * n;
+    part[0] = 0;
+    i = 0;
+    for (t = 1; t < parts; ++t)
+    {
+        target = total * t / parts;
+        while (i < n && (long long)(ap[i] - ap[0]) + (long long)weight * i < target)
+            ++i;
+        part[t] = i;
+    }
+    part[parts] = n;
+}
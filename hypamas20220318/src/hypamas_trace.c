@@ -0,0 +1,270 @@
+/*used to record the per-phase & per-thread trace of the extension and export it*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hypamas_ext_internal.h"
+
+/**
+ * @brief One interval of the timeline, times in nanoseconds from the start of the trace
+ */
+typedef struct
+{
+    long long start;
+    long long end;
+    double flops;
+    int phase;
+} _TraceEvent;
+
+/**
+ * @brief Counters & timeline of one thread, written by that thread only
+ * Hypamas_TraceStart only bumps the generation, the thread restarts its own counters & resizes its own timeline on its next record,
+ * so that no buffer is freed while its thread may be recording into it.
+ */
+typedef struct
+{
+    int generation; /* of the trace the counters belong to */
+    long long calls[kTracePhaseCount];
+    long long time[kTracePhaseCount]; /* nanoseconds */
+    double flops[kTracePhaseCount];
+    long long tasks;
+    _TraceEvent *events;
+    int capacity;
+    int count;
+    long long dropped;
+} _TraceThread;
+
+static int g_trace_on = 0;
+static int g_trace_generation = 0; /* bumped by Hypamas_TraceStart */
+static int g_trace_capacity = 0;   /* events per thread */
+static double g_trace_origin = 0; /* wall time of Hypamas_TraceStart */
+static int g_trace_threads = 0;   /* slots taken */
+static _TraceThread *g_trace_slot[HYPAMAS_TRACE_MAX_THREADS];
+static __thread int t_trace_slot = -1;
+
+static const char *g_trace_name[kTracePhaseCount] = {
+    "region", "wait", "transpose", "ilu analyze", "ilu factorize", "ilu solve", "gmres", "batch", "async request"};
+
+/*Slot of the calling thread, taken on its first record, NULL beyond HYPAMAS_TRACE_MAX_THREADS threads.*/
+static _TraceThread *_TraceSelf(void)
+{
+    _TraceThread *t;
+    int slot;
+
+    if (t_trace_slot >= 0)
+        return g_trace_slot[t_trace_slot];
+
+    slot = __atomic_fetch_add(&g_trace_threads, 1, __ATOMIC_RELAXED);
+    if (slot >= HYPAMAS_TRACE_MAX_THREADS)
+    {
+        __atomic_store_n(&g_trace_threads, HYPAMAS_TRACE_MAX_THREADS, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    t = (_TraceThread *)_HypamasCalloc(1, sizeof(_TraceThread));
+    if (NULL != t)
+        t->generation = -1;
+    __atomic_store_n(&g_trace_slot[slot], t, __ATOMIC_RELEASE);
+    t_trace_slot = slot;
+
+    return t;
+}
+
+/*Counters & timeline of the calling thread for the current trace, restarted by the thread itself after Hypamas_TraceStart.*/
+static _TraceThread *_TraceOwn(void)
+{
+    _TraceThread *t;
+    int generation;
+
+    t = _TraceSelf();
+    if (NULL == t)
+        return NULL;
+    generation = __atomic_load_n(&g_trace_generation, __ATOMIC_ACQUIRE);
+    if (t->generation == generation)
+        return t;
+
+    if (t->capacity != g_trace_capacity)
+    {
+        _HypamasFree(t->events);
+        t->events = g_trace_capacity > 0 ? (_TraceEvent *)_HypamasMalloc(sizeof(_TraceEvent) * g_trace_capacity) : NULL;
+        t->capacity = NULL != t->events ? g_trace_capacity : 0;
+    }
+    memset(t->calls, 0, sizeof(t->calls));
+    memset(t->time, 0, sizeof(t->time));
+    memset(t->flops, 0, sizeof(t->flops));
+    t->tasks = 0;
+    t->count = 0;
+    t->dropped = 0;
+    __atomic_store_n(&t->generation, generation, __ATOMIC_RELEASE);
+
+    return t;
+}
+
+/*Slot i if it holds counters of the current trace, the slots of threads not recorded since Hypamas_TraceStart are empty.*/
+static _TraceThread *_TraceSlot(int i)
+{
+    _TraceThread *t;
+
+    t = __atomic_load_n(&g_trace_slot[i], __ATOMIC_ACQUIRE);
+    if (NULL == t || __atomic_load_n(&t->generation, __ATOMIC_ACQUIRE) != __atomic_load_n(&g_trace_generation, __ATOMIC_ACQUIRE))
+        return NULL;
+    return t;
+}
+
+long long _HypamasTraceClock(void)
+{
+    long long ns;
+
+    if (!__atomic_load_n(&g_trace_on, __ATOMIC_RELAXED))
+        return 0;
+    ns = (long long)(1e9 * (_HypamasWallTime() - g_trace_origin));
+    return _HYPAMAS_MAX(1, ns);
+}
+
+void _HypamasTraceRecord(
+    IN__ int phase,
+    IN__ long long start,
+    IN__ double flops)
+{
+    _TraceThread *t;
+    _TraceEvent *e;
+    long long end;
+
+    if (0 == start || !__atomic_load_n(&g_trace_on, __ATOMIC_RELAXED))
+        return;
+    t = _TraceOwn();
+    if (NULL == t)
+        return;
+
+    end = (long long)(1e9 * (_HypamasWallTime() - g_trace_origin));
+    ++t->calls[phase];
+    t->time[phase] += end - start;
+    t->flops[phase] += flops;
+
+    if (t->count < t->capacity)
+    {
+        e = t->events + t->count++;
+        e->start = start;
+        e->end = end;
+        e->flops = flops;
+        e->phase = phase;
+    }
+    else if (t->capacity > 0)
+    {
+        ++t->dropped;
+    }
+}
+
+void _HypamasTraceTasks(
+    IN__ long long tasks)
+{
+    _TraceThread *t;
+
+    if (0 == tasks || !__atomic_load_n(&g_trace_on, __ATOMIC_RELAXED))
+        return;
+    t = _TraceOwn();
+    if (NULL != t)
+        t->tasks += tasks;
+}
+
+int Hypamas_TraceStart(
+    IN__ int events)
+{
+    if (events < 0)
+        return kErrorInvalidArgument;
+
+    /*the slots of the threads seen so far are kept, each thread restarts its own counters & timeline on its next record*/
+    __atomic_store_n(&g_trace_on, 0, __ATOMIC_SEQ_CST);
+    g_trace_capacity = events;
+    __atomic_fetch_add(&g_trace_generation, 1, __ATOMIC_ACQ_REL);
+
+    g_trace_origin = _HypamasWallTime();
+    __atomic_store_n(&g_trace_on, 1, __ATOMIC_SEQ_CST);
+
+    return kHypamasOK;
+}
+
+int Hypamas_TraceStop(void)
+{
+    __atomic_store_n(&g_trace_on, 0, __ATOMIC_SEQ_CST);
+    return kHypamasOK;
+}
+
+int Hypamas_TraceStats(
+    OUT__ HypamasTraceStats *stats)
+{
+    _TraceThread *t;
+    HypamasTraceThreadStats *ts;
+    int i, p;
+
+    if (NULL == stats)
+        return kErrorInvalidArgument;
+
+    memset(stats, 0, sizeof(HypamasTraceStats));
+    stats->threads = _HYPAMAS_MIN(__atomic_load_n(&g_trace_threads, __ATOMIC_ACQUIRE), HYPAMAS_TRACE_MAX_THREADS);
+    for (i = 0; i < stats->threads; ++i)
+    {
+        t = _TraceSlot(i);
+        if (NULL == t)
+            continue;
+        for (p = 0; p < kTracePhaseCount; ++p)
+        {
+            stats->phase[p].calls += t->calls[p];
+            stats->phase[p].time += 1e-9 * (double)t->time[p];
+            stats->phase[p].flops += t->flops[p];
+        }
+
+        /*waits are recorded inside the regions, busy is what is left of them*/
+        ts = stats->thread + i;
+        ts->regions = t->calls[kTracePhaseRegion];
+        ts->wait = 1e-9 * (double)t->time[kTracePhaseWait];
+        ts->busy = _HYPAMAS_MAX(0., 1e-9 * (double)(t->time[kTracePhaseRegion] - t->time[kTracePhaseWait]));
+        ts->tasks = t->tasks;
+        stats->events += t->count;
+        stats->dropped += t->dropped;
+    }
+
+    return kHypamasOK;
+}
+
+int Hypamas_TraceExport(
+    IN__ char *file)
+{
+    _TraceThread *t;
+    _TraceEvent *e;
+    FILE *fp;
+    int i, k, threads;
+
+    if (NULL == file)
+        return kErrorInvalidArgument;
+    fp = fopen(file, "w");
+    if (NULL == fp)
+        return kErrorOpenFileFail;
+
+    /*Chrome trace event format, complete events in microseconds, one track per thread*/
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"hypamas\"}}");
+    threads = _HYPAMAS_MIN(__atomic_load_n(&g_trace_threads, __ATOMIC_ACQUIRE), HYPAMAS_TRACE_MAX_THREADS);
+    for (i = 0; i < threads; ++i)
+    {
+        t = _TraceSlot(i);
+        if (NULL == t)
+            continue;
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", i, i);
+        for (k = 0; k < t->count; ++k)
+        {
+            e = t->events + k;
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    g_trace_name[e->phase], i, 1e-3 * (double)e->start, 1e-3 * (double)(e->end - e->start));
+            if (e->flops > 0.)
+                fprintf(fp, ",\"args\":{\"flops\":%.17g}", e->flops);
+            fprintf(fp, "}");
+        }
+    }
+    fprintf(fp, "\n]}\n");
+
+    if (0 != fclose(fp))
+        return kErrorOpenFileFail;
+    return kHypamasOK;
+}
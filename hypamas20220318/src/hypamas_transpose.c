@@ -0,0 +1,164 @@
+/*used to define the parallel transpose of sparse patterns shared by the analysis and the solvers of the extension*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "hypamas_ext_internal.h"
+
+#define _TRANSPOSE_NNZ_PER_THREAD 65536 /* minimum non-zeros per thread */
+
+typedef struct
+{
+    int n;
+    const int *ab;
+    const int *ae;
+    const int *ai;
+    const double *ax;
+    int *bp;
+    int *bi;
+    double *bx;
+    int *bmap;
+    const int *part; /* rows of each thread, threads+1 */
+    int *count;      /* n per thread, the counts and then the next slot of each column */
+    int *sum;        /* entries of the columns of each thread, threads+1 */
+    _HypamasTeam *team;
+} _TransposeArgs;
+
+/*Thread t takes a contiguous block of rows and owns the slots after those of threads < t in every column,*/
+/*so the entries of each column stay in ascending rows whatever the number of threads.*/
+static void _TransposeProc(void *arg, int tid, int threads)
+{
+    _TransposeArgs *a = (_TransposeArgs *)arg;
+    const int n = a->n;
+    int *count = a->count + (size_t)tid * n;
+    int i, p, q, c, t, c0, c1, s, v;
+
+    memset(count, 0, sizeof(int) * n);
+    for (i = a->part[tid]; i < a->part[tid + 1]; ++i)
+    {
+        for (p = a->ab[i]; p < a->ae[i]; ++p)
+            ++count[a->ai[p]];
+    }
+    _HypamasTeamBarrier(a->team, threads);
+
+    c0 = (int)((long long)n * tid / threads);
+    c1 = (int)((long long)n * (tid + 1) / threads);
+    s = 0;
+    for (c = c0; c < c1; ++c)
+    {
+        for (t = 0; t < threads; ++t)
+            s += a->count[(size_t)t * n + c];
+    }
+    a->sum[tid + 1] = s;
+    _HypamasTeamBarrier(a->team, threads);
+
+    if (0 == tid)
+    {
+        a->sum[0] = 0;
+        for (t = 0; t < threads; ++t)
+            a->sum[t + 1] += a->sum[t];
+        a->bp[n] = a->sum[threads];
+    }
+    _HypamasTeamBarrier(a->team, threads);
+
+    s = a->sum[tid];
+    for (c = c0; c < c1; ++c)
+    {
+        a->bp[c] = s;
+        for (t = 0; t < threads; ++t)
+        {
+            v = a->count[(size_t)t * n + c];
+            a->count[(size_t)t * n + c] = s;
+            s += v;
+        }
+    }
+    _HypamasTeamBarrier(a->team, threads);
+
+    for (i = a->part[tid]; i < a->part[tid + 1]; ++i)
+    {
+        for (p = a->ab[i]; p < a->ae[i]; ++p)
+        {
+            q = count[a->ai[p]]++;
+            a->bi[q] = i;
+            if (NULL != a->bx)
+                a->bx[q] = a->ax[p];
+            if (NULL != a->bmap)
+                a->bmap[q] = p;
+        }
+    }
+}
+
+int _HypamasTranspose(
+    IN__ int n,
+    IN__ const int *ab,
+    IN__ const int *ae,
+    IN__ const int *ai,
+    IN__ const double *ax,
+    OUT__ int *bp,
+    OUT__ int *bi,
+    OUT__ double *bx,
+    OUT__ int *bmap,
+    IN__ int threads)
+{
+    _TransposeArgs args;
+    int part[2], sum[2], retval;
+    long long start;
+    size_t mark;
+
+    start = _HypamasTraceClock();
+    threads = _HYPAMAS_MAX(1, _HYPAMAS_MIN(threads, (ab[n] - ab[0]) / _TRANSPOSE_NNZ_PER_THREAD));
+
+    args.n = n;
+    args.ab = ab;
+    args.ae = ae;
+    args.ai = ai;
+    args.ax = ax;
+    args.bp = bp;
+    args.bi = bi;
+    args.bx = bx;
+    args.bmap = bmap;
+    args.team = NULL;
+
+    mark = _HypamasArenaMark();
+    args.count = (int *)_HypamasArenaAlloc(sizeof(int) * n * threads);
+    if (1 == threads)
+    {
+        part[0] = 0;
+        part[1] = n;
+        args.part = part;
+        args.sum = sum;
+    }
+    else
+    {
+        args.part = (int *)_HypamasArenaAlloc(sizeof(int) * (threads + 1));
+        args.sum = (int *)_HypamasArenaAlloc(sizeof(int) * (threads + 1));
+    }
+    if (NULL == args.count || NULL == args.part || NULL == args.sum)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+
+    if (1 == threads)
+    {
+        /*the barriers of a single thread region do not touch the team*/
+        _TransposeProc(&args, 0, 1);
+        retval = kHypamasOK;
+        goto FINAL;
+    }
+
+    _HypamasPartitionRows(n, ab, 1, threads, (int *)args.part);
+    retval = _HypamasTeamAcquire(&args.team, threads);
+    if (FAIL(retval))
+        goto FINAL;
+    _HypamasTeamRun(args.team, threads, _TransposeProc, &args);
+    _HypamasTeamRelease(args.team);
+
+FINAL:
+
+    _HypamasArenaReset(mark);
+    _HypamasTraceRecord(kTracePhaseTranspose, start, 0.);
+
+    return retval;
+}
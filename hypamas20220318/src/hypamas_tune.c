@@ -0,0 +1,319 @@
+/*used to time the refactorization paths of a pattern, keep the fastest and cache it by the pattern*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hypamas_ext_internal.h"
+
+#define _TUNE_ROUNDS 5     /* timed refactorizations & solves of a path by default */
+#define _TUNE_MAX_ROUNDS 64
+#define _TUNE_SATURATED 1.05 /* speedup below which more threads are not tried */
+#define _TUNE_CACHE_HEADER "# hypamas tuning cache 1: checksum n nnz created kernel threads refactorize solve"
+
+/**
+ * @brief Settings of the handler changed by the tuner, restored or replaced by the winner
+ */
+typedef struct
+{
+    int min_column;
+    int panel;
+    int map_link_off;
+} _TuneKnobs;
+
+/*iparm selecting kernel, the others as the caller set them*/
+static void _TuneKnobsOf(const _TuneKnobs *user, int kernel, int n, _TuneKnobs *knobs)
+{
+    *knobs = *user;
+    switch (kernel)
+    {
+    case kTuneKernelColumn:
+        knobs->min_column = n + 1; /* no supernode reaches n + 1 columns */
+        break;
+    case kTuneKernelPanel:
+        knobs->panel = 2 * _HYPAMAS_MAX(1, user->panel);
+        break;
+    case kTuneKernelMap:
+        knobs->map_link_off = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+/*Factorize again with the symbolic of kernel, the next refactorizations follow that path.*/
+static int _TuneFactorize(_HypamasHandler *h, const _TuneKnobs *knobs, double *ax, int threads)
+{
+    int fast_off, retval;
+
+    h->iparm[kIparmSupernodeMinColumn] = knobs->min_column;
+    h->iparm[kIparmPanelSize] = knobs->panel;
+    h->iparm[kIparmMapLinkOff] = knobs->map_link_off;
+
+    fast_off = h->iparm[kIparmFastOff];
+    h->iparm[kIparmFastOff] = 1;
+    retval = HypamasFactorize(h, ax, threads);
+    h->iparm[kIparmFastOff] = fast_off;
+
+    return retval;
+}
+
+static double _TuneMedian(double *t, int k)
+{
+    double v;
+    int i, j;
+
+    for (i = 1; i < k; ++i)
+    {
+        v = t[i];
+        for (j = i - 1; j >= 0 && t[j] > v; --j)
+            t[j + 1] = t[j];
+        t[j + 1] = v;
+    }
+    return k % 2 ? t[k / 2] : 0.5 * (t[k / 2 - 1] + t[k / 2]);
+}
+
+/*Median seconds of rounds refactorizations and solves of the path last factorized, after one of each not timed.*/
+static int _TuneTime(_HypamasHandler *h, double *ax, double *rhs, double *sol, int threads, int rounds, double *refact, double *solve)
+{
+    double t[_TUNE_MAX_ROUNDS], s[_TUNE_MAX_ROUNDS], t0;
+    int r, retval;
+
+    retval = HypamasReFactorize(h, ax, threads);
+    if (OK(retval))
+        retval = HypamasSolve(h, rhs, sol, threads);
+    for (r = 0; r < rounds && OK(retval); ++r)
+    {
+        t0 = _HypamasWallTime();
+        retval = HypamasReFactorize(h, ax, threads);
+        t[r] = _HypamasWallTime() - t0;
+        if (FAIL(retval))
+            break;
+        t0 = _HypamasWallTime();
+        retval = HypamasSolve(h, rhs, sol, threads);
+        s[r] = _HypamasWallTime() - t0;
+    }
+    if (FAIL(retval))
+        return retval;
+
+    *refact = _TuneMedian(t, rounds);
+    *solve = _TuneMedian(s, rounds);
+    return retval;
+}
+
+static int _TuneCacheFind(const char *cache, unsigned long long checksum, int n, int nnz, int created, HypamasTuneResult *result)
+{
+    FILE *fp;
+    char line[256];
+    unsigned long long c;
+    int cn, cnnz, ccreated, kernel, threads, found;
+    double refact, solve;
+
+    fp = fopen(cache, "r");
+    if (NULL == fp)
+        return 0;
+
+    found = 0;
+    while (!found && NULL != fgets(line, sizeof(line), fp))
+    {
+        if (8 != sscanf(line, "%llx %d %d %d %d %d %lf %lf", &c, &cn, &cnnz, &ccreated, &kernel, &threads, &refact, &solve))
+            continue;
+        if (c != checksum || cn != n || cnnz != nnz || ccreated != created)
+            continue;
+        if (kernel < kTuneKernelSupernode || kernel > kTuneKernelMap || threads < 1 || threads > created)
+            continue;
+        result->kernel = kernel;
+        result->threads = threads;
+        result->refactorize = refact;
+        result->solve = solve;
+        found = 1;
+    }
+    fclose(fp);
+
+    return found;
+}
+
+/*Replace or append the entry of the pattern, written to a temporary file renamed over the cache so that readers never see a partial file.*/
+static int _TuneCacheStore(const char *cache, unsigned long long checksum, int n, int nnz, int created, const HypamasTuneResult *result)
+{
+    FILE *in, *out;
+    char line[256], *tmp;
+    unsigned long long c;
+    int cn, cnnz, ccreated;
+    size_t len;
+
+    len = strlen(cache) + 32;
+    tmp = (char *)_HypamasMalloc(len);
+    if (NULL == tmp)
+        return kErrorOutOfMemory;
+    snprintf(tmp, len, "%s.%ld.tmp", cache, (long)getpid());
+
+    out = fopen(tmp, "w");
+    if (NULL == out)
+    {
+        _HypamasFree(tmp);
+        return kErrorOpenFileFail;
+    }
+    fprintf(out, "%s\n", _TUNE_CACHE_HEADER);
+    in = fopen(cache, "r");
+    if (NULL != in)
+    {
+        while (NULL != fgets(line, sizeof(line), in))
+        {
+            if (4 != sscanf(line, "%llx %d %d %d", &c, &cn, &cnnz, &ccreated))
+                continue;
+            if (c == checksum && cn == n && cnnz == nnz && ccreated == created)
+                continue;
+            fputs(line, out);
+        }
+        fclose(in);
+    }
+    fprintf(out, "%016llx %d %d %d %d %d %.6e %.6e\n", checksum, n, nnz, created,
+            result->kernel, result->threads, result->refactorize, result->solve);
+
+    if (0 != fclose(out) || 0 != rename(tmp, cache))
+    {
+        remove(tmp);
+        _HypamasFree(tmp);
+        return kErrorOpenFileFail;
+    }
+    _HypamasFree(tmp);
+
+    return kHypamasOK;
+}
+
+int HypamasTune(
+    INOUT__ void *handler,
+    IN__ double *ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ char *cache,
+    IN__ int rounds,
+    OUT__ HypamasTuneResult *result)
+{
+    _HypamasHandler *h;
+    _TuneKnobs user, knobs;
+    HypamasTuneResult best;
+    unsigned long long checksum;
+    double *rhs, *sol, gflop, refact, solve, seq, prev, cost;
+    int n, nnz, created, kernel, threads, retval, failed, auto_off, i;
+
+    if (NULL == handler || NULL == ax || NULL == ap || NULL == ai || NULL == result)
+        return kErrorInvalidArgument;
+    if (rounds <= 0)
+        rounds = _TUNE_ROUNDS;
+    if (rounds > _TUNE_MAX_ROUNDS)
+        return kErrorInvalidArgument;
+
+    h = _HYPAMAS_HANDLER(handler);
+    if (!_HYPAMAS_INITIALIZED(h))
+        return kErrorPhaseNotInitialized;
+    if (!_HYPAMAS_ANALYZED(h))
+        return kErrorPhaseNotAnalyzed;
+
+    n = h->n;
+    nnz = ap[n] - ap[0];
+    created = _HYPAMAS_MAX(1, h->iparm[kIparmThreadCreated]);
+    checksum = _HypamasPatternChecksum(n, ap, ai);
+    gflop = h->dparm[kDparmGFlopsAnalyzed];
+    user.min_column = h->iparm[kIparmSupernodeMinColumn];
+    user.panel = h->iparm[kIparmPanelSize];
+    user.map_link_off = h->iparm[kIparmMapLinkOff];
+
+    /*the threads given are used as they are, the automatical control would override the choice.*/
+    /*it is restored whenever no winner is applied*/
+    auto_off = h->iparm[kIparmAutoParallelOff];
+    h->iparm[kIparmAutoParallelOff] = 1;
+
+    memset(&best, 0, sizeof(best));
+    if (NULL != cache && _TuneCacheFind(cache, checksum, n, nnz, created, &best))
+    {
+        _TuneKnobsOf(&user, best.kernel, n, &knobs);
+        retval = _TuneFactorize(h, &knobs, ax, best.threads);
+        if (FAIL(retval))
+        {
+            h->iparm[kIparmAutoParallelOff] = auto_off;
+            return retval;
+        }
+        best.cached = 1;
+        best.gflops = best.refactorize > 0. ? gflop / best.refactorize : 0.;
+        *result = best;
+        return retval;
+    }
+
+    rhs = (double *)_HypamasMalloc(sizeof(double) * n * 2);
+    if (NULL == rhs)
+    {
+        h->iparm[kIparmAutoParallelOff] = auto_off;
+        return kErrorOutOfMemory;
+    }
+    sol = rhs + n;
+    for (i = 0; i < n; ++i)
+        rhs[i] = 1.;
+
+    /*the cost of a path is one refactorization and one solving, as in a Newton step.*/
+    /*the threads of a kernel grow from one, a count is skipped if even a perfect speedup of the sequential time can not beat the best path,*/
+    /*and the growth stops once doubling the threads speeds up by less than _TUNE_SATURATED.*/
+    best.refactorize = best.solve = -1.;
+    failed = kHypamasOK;
+    for (kernel = kTuneKernelSupernode; kernel <= kTuneKernelMap; ++kernel)
+    {
+        _TuneKnobsOf(&user, kernel, n, &knobs);
+        seq = prev = 0.;
+        for (threads = 1; threads <= created; threads = threads < created && 2 * threads > created ? created : 2 * threads)
+        {
+            if (threads > 1 && best.refactorize >= 0. && seq / threads >= best.refactorize + best.solve)
+                break;
+
+            retval = _TuneFactorize(h, &knobs, ax, threads);
+            if (OK(retval))
+                retval = _TuneTime(h, ax, rhs, sol, threads, rounds, &refact, &solve);
+            ++best.candidates;
+            if (FAIL(retval))
+                break;
+
+            cost = refact + solve;
+            if (best.refactorize < 0. || cost < best.refactorize + best.solve)
+            {
+                best.kernel = kernel;
+                best.threads = threads;
+                best.refactorize = refact;
+                best.solve = solve;
+            }
+            if (1 == threads)
+                seq = cost;
+            else if (prev < _TUNE_SATURATED * cost)
+                break;
+            prev = cost;
+        }
+        /*a path failing, e.g. a singular pivot under another symbolic, is skipped*/
+        if (FAIL(retval))
+            failed = retval;
+    }
+    _HypamasFree(rhs);
+
+    /*no path succeeded, the handler is factorized again as the caller set it*/
+    if (best.refactorize < 0.)
+    {
+        h->iparm[kIparmAutoParallelOff] = auto_off;
+        retval = _TuneFactorize(h, &user, ax, 1);
+        return FAIL(retval) ? retval : failed;
+    }
+
+    _TuneKnobsOf(&user, best.kernel, n, &knobs);
+    retval = _TuneFactorize(h, &knobs, ax, best.threads);
+    if (FAIL(retval))
+    {
+        h->iparm[kIparmAutoParallelOff] = auto_off;
+        return retval;
+    }
+    best.gflops = best.refactorize > 0. ? gflop / best.refactorize : 0.;
+    *result = best;
+
+    if (NULL != cache && FAIL(_TuneCacheStore(cache, checksum, n, nnz, created, &best)))
+        retval = kErrorOpenFileFail;
+
+    return retval;
+}
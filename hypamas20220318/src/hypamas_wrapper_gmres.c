@@ -0,0 +1,194 @@
+/*used to wrap the parallel GMRES*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include "hypamas_ext_internal.h"
+
+#define _GMRES_NNZ_PER_THREAD 20000 /* minimum non-zeros per thread under automatical thread control */
+
+typedef struct
+{
+    void *handler;
+    int retval;
+} _HypamasPrecondSolve;
+
+/*preconditioner given by the (incomplete) factors of the handler, applied by tid 0*/
+static int _HypamasPrecondSolveProc(void *data, const double *in, double *out, _HypamasTeam *team, int tid, int threads)
+{
+    _HypamasPrecondSolve *p = (_HypamasPrecondSolve *)data;
+
+    _HypamasTeamBarrier(team, threads);
+    if (0 == tid)
+        p->retval = HypamasSolve(p->handler, (double *)in, out, 1);
+    _HypamasTeamBarrier(team, threads);
+
+    return p->retval;
+}
+
+/*CSR pattern of the CSC input with the position of each entry in ax, the values are not copied, the arrays come from the scratch arena*/
+static int _HypamasGMRESView(int n, const int *ap, const int *ai, int **bp, int **bi, int **bmap, int threads)
+{
+    *bp = (int *)_HypamasArenaAlloc(sizeof(int) * (n + 1));
+    *bi = (int *)_HypamasArenaAlloc(sizeof(int) * ap[n]);
+    *bmap = (int *)_HypamasArenaAlloc(sizeof(int) * ap[n]);
+    if (NULL == *bp || NULL == *bi || NULL == *bmap)
+        return kErrorOutOfMemory;
+
+    return _HypamasTranspose(n, ap, ap + 1, ai, NULL, *bp, *bi, NULL, *bmap, threads);
+}
+
+int _HypamasGMRESRun(
+    INOUT__ void *handler,
+    IN__ double *ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ double *rhs,
+    INOUT__ double *sol,
+    IN__ int threads,
+    IN__ const _HypamasCSRView *view,
+    IN__ _HypamasPrecondProc precond,
+    IN__ void *precond_data)
+{
+    _HypamasHandler *h;
+    _HypamasGMRESContext ctx;
+    _HypamasTeam *team;
+    double *work, t0;
+    long long wake_total, wake_count, total, count, start;
+    int *tap, *tai, *tmap, retval, n, orth, stride, lstride;
+    size_t size, mark;
+
+    h = _HYPAMAS_HANDLER(handler);
+    orth = h->iparm[kIparmGMRESOrthogonalization];
+    if (orth < kCfgGMRESOrthAuto || orth > kCfgGMRESOrthSingleReduce)
+        return kErrorAlgorithmInvalid;
+
+    t0 = _HypamasWallTime();
+    start = _HypamasTraceClock();
+    n = h->n;
+
+    if (threads <= 0)
+        threads = h->iparm[kIparmThreadCreated];
+    if (!h->iparm[kIparmAutoParallelOff])
+        threads = _HYPAMAS_MIN(threads, ap[n] / _GMRES_NNZ_PER_THREAD);
+    threads = _HYPAMAS_MAX(1, threads);
+    if (kCfgGMRESOrthAuto == orth)
+        orth = threads > 1 ? kCfgGMRESOrthSingleReduce : kCfgGMRESOrthMGS;
+
+    ctx.n = n;
+    ctx.ax = ax;
+    ctx.ap = ap;
+    ctx.ai = ai;
+    ctx.map = NULL;
+    ctx.rhs = rhs;
+    ctx.sol = sol;
+    ctx.precond = precond;
+    ctx.precond_data = precond_data;
+    ctx.restart = _HYPAMAS_MAX(1, h->iparm[kIparmKrylovDimension]);
+    ctx.maxiter = _HYPAMAS_MAX(0, h->iparm[kIparmKrylovMaxIter]);
+    ctx.stagnation = h->iparm[kIparmStagnationStep] > 0 ? h->iparm[kIparmStagnationStep] : ctx.maxiter + 1;
+    ctx.orth = orth;
+    ctx.tol = h->dparm[kDparmGMRESMetricTolerance];
+    ctx.iter = 0;
+    ctx.retval = kHypamasOK;
+
+    /*all workspaces come from the scratch arena of the calling thread, a repeated solve does not allocate*/
+    mark = _HypamasArenaMark();
+
+    /*a CSC input is multiplied through the CSR view of its pattern, gathering from ax*/
+    if (h->iparm[kIparmSolveTranspose])
+    {
+        if (NULL != view)
+        {
+            ctx.ap = view->ap;
+            ctx.ai = view->ai;
+            ctx.map = view->map;
+        }
+        else
+        {
+            retval = _HypamasGMRESView(n, ap, ai, &tap, &tai, &tmap, threads);
+            if (FAIL(retval))
+                goto FINAL;
+            ctx.ap = tap;
+            ctx.ai = tai;
+            ctx.map = tmap;
+        }
+    }
+
+    stride = (ctx.restart + 2 + 7) / 8 * 8;
+    lstride = _HypamasGMRESLocalSize(ctx.restart);
+    size = (size_t)(ctx.restart + 3) * n + (size_t)2 * threads * stride + (size_t)threads * lstride;
+    work = (double *)_HypamasArenaAlloc(sizeof(double) * size);
+    ctx.part = (int *)_HypamasArenaAlloc(sizeof(int) * (threads + 1));
+    if (NULL == work || NULL == ctx.part)
+    {
+        retval = kErrorOutOfMemory;
+        goto FINAL;
+    }
+    ctx.v = work;
+    ctx.z = ctx.v + (size_t)(ctx.restart + 1) * n;
+    ctx.w = ctx.z + n;
+    ctx.reduce = ctx.w + n;
+    ctx.stride = stride;
+    ctx.local = ctx.reduce + (size_t)2 * threads * stride;
+    ctx.lstride = lstride;
+    _HypamasPartitionRows(n, ctx.ap, 4, threads, ctx.part);
+
+    retval = _HypamasTeamAcquire(&team, threads);
+    if (FAIL(retval))
+        goto FINAL;
+    _HypamasTeamWakeCounters(&wake_total, &wake_count);
+    _HypamasGMRESParallel(&ctx, team, threads);
+    _HypamasTeamWakeCounters(&total, &count);
+    _HypamasTeamRelease(team);
+
+    retval = ctx.retval;
+    if (kHypamasOK == retval && NULL == ctx.precond)
+        retval = kWarningNoPreconditioner;
+    h->iparm[kIparmIterNum] = ctx.iter;
+    h->iparm[kIparmThreadUsed] = threads;
+    if (h->iparm[kIparmTimer])
+    {
+        h->dparm[kDparmSolveTime] = _HypamasWallTime() - t0;
+        h->dparm[kDparmThreadWakeLatency] = count > wake_count ? 1e-9 * (double)(total - wake_total) / (double)(count - wake_count) : 0.;
+    }
+
+FINAL:
+
+    /*an iteration multiplies by A and orthogonalizes against restart/2 vectors on average*/
+    _HypamasTraceRecord(kTracePhaseGMRES, start, ctx.iter * (2. * ap[n] + 2. * n * ctx.restart));
+    _HypamasArenaReset(mark);
+
+    return retval;
+}
+
+int HypamasParallelGMRES(
+    INOUT__ void *handler,
+    IN__ double *ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ double *rhs,
+    INOUT__ double *sol,
+    IN__ int threads)
+{
+    _HypamasHandler *h;
+    _HypamasPrecondSolve precond;
+
+    if (NULL == handler || NULL == ax || NULL == ap || NULL == ai || NULL == rhs || NULL == sol)
+        return kErrorInvalidArgument;
+
+    h = _HYPAMAS_HANDLER(handler);
+    if (!_HYPAMAS_INITIALIZED(h))
+        return kErrorPhaseNotInitialized;
+    if (!_HYPAMAS_ANALYZED(h))
+        return kErrorPhaseNotAnalyzed;
+
+    precond.handler = handler;
+    precond.retval = kHypamasOK;
+    if (kCfgInFactPreconditionerOff == h->iparm[kIparmInFactAlgorithm])
+        return _HypamasGMRESRun(handler, ax, ap, ai, rhs, sol, threads, NULL, NULL, NULL);
+    if (!_HYPAMAS_FACTORIZED(h))
+        return kErrorPhaseNotFactorized;
+
+    return _HypamasGMRESRun(handler, ax, ap, ai, rhs, sol, threads, NULL, _HypamasPrecondSolveProc, &precond);
+}
@@ -0,0 +1,354 @@
+/*used to wrap the level-scheduled ILU(k) preconditioner*/
+/*last modified: Oct 17, 2026*/
+/*author: Penguin*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "hypamas_ext_internal.h"
+
+typedef struct
+{
+    _HypamasLevelILU *ilu;
+    _HypamasTeam *team;
+    const double *in;
+    double *out;
+} _HypamasLevelILUSolveArgs;
+
+static void _HypamasLevelILUSolveProc(void *arg, int tid, int threads)
+{
+    _HypamasLevelILUSolveArgs *args = (_HypamasLevelILUSolveArgs *)arg;
+    _HypamasLevelILUApply(args->ilu, args->in, args->out, args->team, tid, threads);
+}
+
+int HypamasLevelILUInit(
+    OUT__ void **ilu,
+    IN__ int fill)
+{
+    if (NULL == ilu || fill < 0)
+        return kErrorInvalidArgument;
+
+    *ilu = _HypamasCalloc(1, sizeof(_HypamasLevelILU));
+    if (NULL == *ilu)
+        return kErrorOutOfMemory;
+    ((_HypamasLevelILU *)*ilu)->fill = fill;
+
+    return kHypamasOK;
+}
+
+int HypamasLevelILUSetPrecision(
+    INOUT__ void *ilu,
+    IN__ int precision)
+{
+    if (NULL == ilu || (kCfgILUPrecisionDouble != precision && kCfgILUPrecisionSingle != precision))
+        return kErrorInvalidArgument;
+
+    ((_HypamasLevelILU *)ilu)->precision = precision;
+
+    return kHypamasOK;
+}
+
+int HypamasLevelILUSetSchedule(
+    INOUT__ void *ilu,
+    IN__ int schedule)
+{
+    if (NULL == ilu || (kCfgILUScheduleLevel != schedule && kCfgILUScheduleSteal != schedule))
+        return kErrorInvalidArgument;
+
+    ((_HypamasLevelILU *)ilu)->schedule = schedule;
+
+    return kHypamasOK;
+}
+
+int HypamasLevelILUSetExact(
+    INOUT__ void *ilu,
+    IN__ int exact)
+{
+    _HypamasLevelILU *p;
+
+    if (NULL == ilu)
+        return kErrorInvalidArgument;
+
+    p = (_HypamasLevelILU *)ilu;
+    p->exact = 0 != exact;
+    /*an analysis of a lower level of fill is dropped, the next factorization analyzes again*/
+    if (p->exact && NULL != p->bp && p->fill < p->n)
+        _HypamasLevelILUFree(p);
+
+    return kHypamasOK;
+}
+
+int HypamasLevelILUFinalize(
+    IN__ void *ilu)
+{
+    if (NULL == ilu)
+        return kErrorInvalidArgument;
+
+    _HypamasLevelILUFree((_HypamasLevelILU *)ilu);
+    _HypamasFree(ilu);
+
+    return kHypamasOK;
+}
+
+int HypamasLevelILUFactorize(
+    INOUT__ void *ilu,
+    IN__ int n,
+    IN__ double *ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ int mode,
+    IN__ int threads)
+{
+    _HypamasLevelILU *p;
+    int retval;
+    long long start;
+    double flops;
+
+    if (NULL == ilu || NULL == ax || NULL == ap || NULL == ai || n <= 0)
+        return kErrorInvalidArgument;
+
+    p = (_HypamasLevelILU *)ilu;
+    mode = 0 != mode;
+    if (NULL == p->bp)
+    {
+        start = _HypamasTraceClock();
+        retval = _HypamasLevelILUSymbolic(p, n, ax, ap, ai, mode, threads);
+        _HypamasTraceRecord(kTracePhaseILUAnalyze, start, 0.);
+        if (FAIL(retval))
+            return retval;
+    }
+    else if (n != p->n || ap[n] != p->nnz || mode != p->mode)
+    {
+        return kErrorMatrixConsistencyCheck;
+    }
+
+    flops = 0 != _HypamasTraceClock() ? _HypamasLevelILUFlops(p) : 0.;
+    start = _HypamasTraceClock();
+    retval = _HypamasLevelILUNumeric(p, ax, _HYPAMAS_MAX(1, threads));
+    _HypamasTraceRecord(kTracePhaseILUFactorize, start, flops);
+
+    return retval;
+}
+
+int HypamasLevelILUPartialFactorize(
+    INOUT__ void *ilu,
+    IN__ double *ax,
+    IN__ int *changed,
+    IN__ int nchanged,
+    IN__ int threads,
+    OUT__ int *updated)
+{
+    _HypamasLevelILU *p;
+    int retval;
+    long long start;
+
+    if (NULL == ilu || NULL == ax || nchanged < 0 || (nchanged > 0 && NULL == changed))
+        return kErrorInvalidArgument;
+
+    p = (_HypamasLevelILU *)ilu;
+    if (!p->factorized)
+        return kErrorPhaseNotFactorized;
+
+    /*the rows recomputed are not known ahead, no flops are estimated*/
+    start = _HypamasTraceClock();
+    retval = _HypamasLevelILUPartialNumeric(p, ax, changed, nchanged, _HYPAMAS_MAX(1, threads), updated);
+    _HypamasTraceRecord(kTracePhaseILUFactorize, start, 0.);
+
+    return retval;
+}
+
+int HypamasLevelILUSolve(
+    IN__ void *ilu,
+    INOUT__ double *rhs,
+    OUT__ double *sol,
+    IN__ int threads)
+{
+    _HypamasLevelILUSolveArgs args;
+    _HypamasLevelILU *p;
+    int retval;
+
+    if (NULL == ilu || NULL == rhs)
+        return kErrorInvalidArgument;
+
+    p = (_HypamasLevelILU *)ilu;
+    if (!p->factorized)
+        return kErrorPhaseNotFactorized;
+
+    args.ilu = p;
+    args.in = rhs;
+    args.out = NULL == sol ? p->work : sol;
+
+    threads = _HYPAMAS_MAX(1, threads);
+    if (!_HypamasLevelILUWide(p, threads))
+        threads = 1;
+    retval = _HypamasTeamAcquire(&args.team, threads);
+    if (FAIL(retval))
+        return retval;
+    _HypamasTeamRun(args.team, threads, _HypamasLevelILUSolveProc, &args);
+    _HypamasTeamRelease(args.team);
+
+    if (NULL == sol)
+        memcpy(rhs, p->work, sizeof(double) * p->n);
+
+    return kHypamasOK;
+}
+
+int HypamasLevelILUSparseSolve(
+    IN__ void *ilu,
+    IN__ int nz,
+    IN__ int *idx,
+    IN__ double *val,
+    IN__ int nout,
+    IN__ int *out,
+    OUT__ double *sol,
+    OUT__ int *reach)
+{
+    _HypamasLevelILU *p;
+    int i;
+
+    if (NULL == ilu || nz < 0 || nout < 0 || (nz > 0 && (NULL == idx || NULL == val)) || (nout > 0 && (NULL == out || NULL == sol)))
+        return kErrorInvalidArgument;
+
+    p = (_HypamasLevelILU *)ilu;
+    if (!p->factorized)
+        return kErrorPhaseNotFactorized;
+    for (i = 0; i < nz; ++i)
+    {
+        if (idx[i] < 0 || idx[i] >= p->n)
+            return kErrorInvalidArgument;
+    }
+    for (i = 0; i < nout; ++i)
+    {
+        if (out[i] < 0 || out[i] >= p->n)
+            return kErrorInvalidArgument;
+    }
+
+    return _HypamasLevelILUSparseSolve(p, nz, idx, val, nout, out, sol, reach);
+}
+
+int HypamasLevelILUGMRES(
+    INOUT__ void *handler,
+    IN__ void *ilu,
+    IN__ double *ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ double *rhs,
+    INOUT__ double *sol,
+    IN__ int threads)
+{
+    _HypamasHandler *h;
+    _HypamasLevelILU *p;
+    _HypamasCSRView view;
+    int retval, iter, precision;
+    double elapsed;
+
+    if (NULL == handler || NULL == ilu || NULL == ax || NULL == ap || NULL == ai || NULL == rhs || NULL == sol)
+        return kErrorInvalidArgument;
+
+    h = _HYPAMAS_HANDLER(handler);
+    if (!_HYPAMAS_INITIALIZED(h))
+        return kErrorPhaseNotInitialized;
+    if (!_HYPAMAS_ANALYZED(h))
+        return kErrorPhaseNotAnalyzed;
+
+    p = (_HypamasLevelILU *)ilu;
+    if (!p->factorized)
+        return kErrorPhaseNotFactorized;
+    if (p->n != h->n || p->nnz != ap[h->n] || p->mode != (0 != h->iparm[kIparmSolveTranspose]))
+        return kErrorMatrixConsistencyCheck;
+
+    /*the CSR view of a CSC input kept from the analysis, so that a solve neither transposes the pattern nor copies ax*/
+    view.ap = p->rp;
+    view.ai = p->ri;
+    view.map = p->rmap;
+    retval = _HypamasGMRESRun(handler, ax, ap, ai, rhs, sol, threads, NULL != p->rmap ? &view : NULL, _HypamasLevelILUApply, p);
+    if (NULL == p->bxs ||
+        (kWarningMaxIterationAchieved != retval && kWarningIterationConvergeSlowly != retval && kWarningIterationConvergeFail != retval))
+        return retval;
+
+    /*the refinement stalls on the single precision factors, fall back to double for this solve,*/
+    /*the precision set by the caller is kept for the next factorization*/
+    iter = h->iparm[kIparmIterNum];
+    elapsed = h->dparm[kDparmSolveTime];
+    precision = p->precision;
+    p->precision = kCfgILUPrecisionDouble;
+    retval = _HypamasLevelILUNumeric(p, ax, _HYPAMAS_MAX(1, threads > 0 ? threads : h->iparm[kIparmThreadCreated]));
+    p->precision = precision;
+    if (FAIL(retval))
+        return retval;
+    retval = _HypamasGMRESRun(handler, ax, ap, ai, rhs, sol, threads, NULL != p->rmap ? &view : NULL, _HypamasLevelILUApply, p);
+    h->iparm[kIparmIterNum] += iter;
+    if (h->iparm[kIparmTimer])
+        h->dparm[kDparmSolveTime] += elapsed;
+
+    return retval;
+}
+
+int HypamasLevelILUBatchFactorize(
+    INOUT__ void *ilu,
+    IN__ int n,
+    IN__ int count,
+    IN__ double **ax,
+    IN__ int *ap,
+    IN__ int *ai,
+    IN__ int mode,
+    IN__ int threads)
+{
+    _HypamasLevelILU *p;
+    int retval, i;
+    long long start;
+    double flops;
+
+    if (NULL == ilu || NULL == ax || NULL == ap || NULL == ai || n <= 0 || count <= 0)
+        return kErrorInvalidArgument;
+    for (i = 0; i < count; ++i)
+    {
+        if (NULL == ax[i])
+            return kErrorInvalidArgument;
+    }
+
+    p = (_HypamasLevelILU *)ilu;
+    mode = 0 != mode;
+    if (NULL == p->bp)
+    {
+        start = _HypamasTraceClock();
+        retval = _HypamasLevelILUSymbolic(p, n, ax[0], ap, ai, mode, threads);
+        _HypamasTraceRecord(kTracePhaseILUAnalyze, start, 0.);
+        if (FAIL(retval))
+            return retval;
+    }
+    else if (n != p->n || ap[n] != p->nnz || mode != p->mode)
+    {
+        return kErrorMatrixConsistencyCheck;
+    }
+
+    flops = 0 != _HypamasTraceClock() ? count * _HypamasLevelILUFlops(p) : 0.;
+    start = _HypamasTraceClock();
+    retval = _HypamasLevelILUBatchNumeric(p, count, ax, _HYPAMAS_MAX(1, threads));
+    _HypamasTraceRecord(kTracePhaseILUFactorize, start, flops);
+
+    return retval;
+}
+
+int HypamasLevelILUBatchSolve(
+    IN__ void *ilu,
+    IN__ double **rhs,
+    OUT__ double **sol,
+    IN__ int threads)
+{
+    _HypamasLevelILU *p;
+    int i;
+
+    if (NULL == ilu || NULL == rhs || NULL == sol)
+        return kErrorInvalidArgument;
+
+    p = (_HypamasLevelILU *)ilu;
+    if (0 == p->batch)
+        return kErrorPhaseNotFactorized;
+    for (i = 0; i < p->batch; ++i)
+    {
+        if (NULL == rhs[i] || NULL == sol[i])
+            return kErrorInvalidArgument;
+    }
+
+    return _HypamasLevelILUBatchSolve(p, rhs, sol, _HYPAMAS_MAX(1, threads));
+}